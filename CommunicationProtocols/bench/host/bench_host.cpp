@@ -0,0 +1,421 @@
+/**
+ * @file bench_host.cpp
+ * @brief Throughput benchmark of the drivers on the host register simulator.
+ *
+ * Builds the unmodified UART, I2C and SPI drivers and the BME280 driver of lib/BME280
+ * against lib/AvrSim and measures how long each operation takes in simulated time on a
+ * 16 MHz ATmega328P, which is dominated by the bus and peripheral timing. The
+ * compensation kernels are timed on the host CPU instead, which only allows comparing
+ * versions with each other on the same machine.
+ *
+ * Every measurement checks its result, so the program exits with a non-zero status when
+ * a driver or the simulator breaks.
+ *
+ * With a file name as argument the simulated measurements, but not the host timings, are
+ * also written there as CSV.
+ * Simulated time does not depend on the host, so the file only changes when a driver or
+ * the simulator does and can be compared with `diff` from commit to commit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "BME280Sim.h"
+#include "BME280.h"
+#include "communication.h"
+
+namespace
+{
+    int failures = 0;
+    FILE *results = nullptr;
+
+    constexpr uint8_t sensor_address = 0x76;
+
+    mm::StaticUART<0, mm::UARTMode::Interrupt> uart(115200);
+    mm::I2C i2c(mm::Hz(400000UL));
+
+    /**
+     * @brief Prints one row of the result table and adds it to the results file.
+     *
+     * @param name What was measured.
+     * @param cycles Simulated CPU cycles the operation took.
+     * @param bytes Payload bytes moved, 0 to omit the throughput.
+     */
+    void row(const char *name, uint64_t cycles, uint32_t bytes)
+    {
+        double us = mm::sim::microseconds(cycles);
+        if (bytes)
+        {
+            printf("%-44s %10.1f us %10.0f B/s\n", name, us, bytes * 1e6 / us);
+        }
+        else
+        {
+            printf("%-44s %10.1f us\n", name, us);
+        }
+
+        if (results)
+        {
+            fprintf(results, "\"%s\",%llu,%.1f,", name, (unsigned long long)cycles, us);
+            if (bytes)
+            {
+                fprintf(results, "%.0f", bytes * 1e6 / us);
+            }
+            fprintf(results, "\n");
+        }
+    }
+
+    /**
+     * @brief Records a failed check.
+     */
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            printf("FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    /**
+     * @brief Forwards to a simulated sensor but does not answer one address phase.
+     */
+    class DroppingTarget : public mm::sim::I2CTarget
+    {
+    private:
+        mm::sim::I2CTarget &target;
+        uint8_t skip;
+        mutable uint8_t phases;
+
+    public:
+        /**
+         * @param target The device that answers all other address phases.
+         * @param skip The number of address phases answered before the dropped one.
+         */
+        DroppingTarget(mm::sim::I2CTarget &target, uint8_t skip) : target(target), skip(skip), phases(0) {}
+
+        uint8_t addressed() const { return phases; }
+
+        uint8_t address() const override { return phases++ == skip ? 0 : target.address(); }
+        void start(bool read) override { target.start(read); }
+        bool write(uint8_t data) override { return target.write(data); }
+        uint8_t read(bool ack) override { return target.read(ack); }
+        void stop() override { target.stop(); }
+    };
+
+    /**
+     * @brief Starts a measurement from a clean simulator with the sensor attached.
+     */
+    void setup(mm::sim::BME280Sim &sensor)
+    {
+        mm::sim::reset();
+        mm::sim::attachI2C(sensor);
+        mm::sim::attachSPI(sensor, PORTB, PB2);
+    }
+
+    void benchUart()
+    {
+        static const char message[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde";
+        const uint32_t len = sizeof(message) - 1;
+        mm::sim::BME280Sim sensor;
+
+        setup(sensor);
+        mm::UART defaulted;
+        defaulted.init();
+        check(defaulted.achievedBaud() == 9615 && defaulted.baudError() == 15, "UART default speed");
+
+        setup(sensor);
+        mm::UART polled(0, 115200);
+        polled.init();
+        uint64_t start = mm::sim::cycles();
+        polled.transmitString(message);
+        polled.flush();
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+        row("UART polling, 63 bytes at 115200 baud", mm::sim::cycles() - start, len);
+        check(mm::sim::uartOutput().size() == len, "UART polling output");
+
+        // Formatted output: a bool is not a number and hex() never exceeds 32 bits
+        static const char formatted[] = "true false 89ABCDEF";
+        mm::sim::uartOutput().clear();
+        UCSR0A |= (1 << TXC0);
+        polled << true << ' ' << false << ' ' << mm::hex(0x89ABCDEFUL, 12);
+        polled.flush();
+        while (!(UCSR0A & (1 << TXC0)))
+            ;
+        check(mm::sim::uartOutput().size() == sizeof(formatted) - 1 &&
+                  memcmp(mm::sim::uartOutput().data(), formatted, sizeof(formatted) - 1) == 0,
+              "UART formatted output");
+
+        setup(sensor);
+        uart.init();
+        sei();
+        start = mm::sim::cycles();
+        uart.transmitString(message);
+        row("UART interrupt, 63 bytes, CPU blocked", mm::sim::cycles() - start, 0);
+        uart.flush();
+        row("UART interrupt, 63 bytes on the wire", mm::sim::cycles() - start, len);
+        check(mm::sim::uartOutput().size() == len &&
+                  memcmp(mm::sim::uartOutput().data(), message, len) == 0,
+              "UART interrupt output");
+
+        // The runtime UART reaches the same buffers through its interrupt mode table
+        setup(sensor);
+        mm::UART buffered(0, 115200, mm::UARTMode::Interrupt);
+        buffered.init();
+        buffered.transmitString(message);
+        buffered.flush();
+        check(mm::sim::uartOutput().size() == len &&
+                  memcmp(mm::sim::uartOutput().data(), message, len) == 0,
+              "UART runtime interrupt output");
+        cli();
+    }
+
+    void benchI2C()
+    {
+        mm::sim::BME280Sim sensor;
+        const mm::Hz frequencies[] = {mm::Hz(100000UL), mm::Hz(400000UL)};
+
+        for (mm::Hz frequency : frequencies)
+        {
+            char name[64];
+            uint8_t data[8];
+
+            setup(sensor);
+            mm::I2C bus(frequency);
+            bus.init();
+            uint64_t start = mm::sim::cycles();
+            mm::I2CStatus status = bus.read_block(sensor_address, 0xF7, data, sizeof(data));
+            snprintf(name, sizeof(name), "I2C read_block 8 bytes, %lu kHz", (unsigned long)frequency.value / 1000);
+            row(name, mm::sim::cycles() - start, sizeof(data));
+            check(status == mm::I2CStatus::Ok && data[0] == 0x80, "I2C read_block");
+
+            sei();
+            uint8_t reg = 0xF7;
+            mm::I2CTransaction transaction = {sensor_address, &reg, 1, data, sizeof(data), nullptr, nullptr,
+                                              mm::I2CStatus::Ok};
+            start = mm::sim::cycles();
+            bus.submit(transaction);
+            snprintf(name, sizeof(name), "I2C submit 8 bytes, %lu kHz, CPU blocked", (unsigned long)frequency.value / 1000);
+            row(name, mm::sim::cycles() - start, 0);
+            status = bus.wait(transaction);
+            snprintf(name, sizeof(name), "I2C submit 8 bytes, %lu kHz, complete", (unsigned long)frequency.value / 1000);
+            row(name, mm::sim::cycles() - start, sizeof(data));
+            check(status == mm::I2CStatus::Ok && data[0] == 0x80, "I2C submit");
+
+            // wait() returns before the STOP is on the bus; a blocking read has to wait for it
+            data[0] = 0;
+            status = bus.read_block(sensor_address, 0xF7, data, sizeof(data));
+            check(status == mm::I2CStatus::Ok && data[0] == 0x80, "I2C read_block after wait()");
+            cli();
+        }
+    }
+
+    void benchSPI()
+    {
+        mm::sim::BME280Sim sensor;
+        const uint32_t clocks[] = {1000000UL, 4000000UL, 8000000UL};
+
+        for (uint32_t clock : clocks)
+        {
+            char name[64];
+            uint8_t data[8];
+
+            setup(sensor);
+            mm::SPIBus bus;
+            mm::SPIDevice device(bus, DDRB, PORTB, PB2, mm::spiSettings(F_CPU, clock, mm::SPIMode::Mode0));
+            bus.init();
+            device.init();
+            check((DDRB & (1 << PB2)) && (PORTB & (1 << PB2)), "SPIDevice chip select");
+            uint64_t start = mm::sim::cycles();
+            device.readBlock(0xF7, data, sizeof(data));
+            snprintf(name, sizeof(name), "SPI readBlock 8 bytes, %lu MHz", (unsigned long)device.frequency() / 1000000);
+            row(name, mm::sim::cycles() - start, sizeof(data));
+            check(data[0] == 0x80 && data[3] == 0x80, "SPI readBlock");
+        }
+    }
+
+    /**
+     * @brief Prints and checks the readings of a sensor, which sees the datasheet example.
+     */
+    template <typename Transport>
+    void checkReadings(const mm::BME280<Transport> &sensor, const char *what)
+    {
+        printf("  %ld.%02ld C  %lu.%02lu hPa  %lu.%02lu %%RH\n", (long)sensor.getTemp() / 100,
+               (long)sensor.getTemp() % 100, (unsigned long)pressureCentiHpa(sensor.getPress()) / 100,
+               (unsigned long)pressureCentiHpa(sensor.getPress()) % 100,
+               (unsigned long)humidityCentiPercent(sensor.getHum()) / 100,
+               (unsigned long)humidityCentiPercent(sensor.getHum()) % 100);
+
+        // Datasheet example: adc_T = 519888 gives 25.08 C, adc_P = 415148 gives 100653.27 Pa
+        check(sensor.getTemp() == 2508, what);
+        int32_t pressure_error = (int32_t)pressureCentiHpa(sensor.getPress()) - 100653;
+        check(BME280_PRESSURE_INT64 ? pressure_error == 0
+                                    : pressure_error <= BME280_PRESSURE_INT32_TOLERANCE_PA &&
+                                          pressure_error >= -BME280_PRESSURE_INT32_TOLERANCE_PA,
+              what);
+    }
+
+    void benchSensor()
+    {
+        mm::sim::BME280Sim sensor;
+        mm::sim::BME280Sim second(0x77);
+
+        setup(sensor);
+        mm::sim::attachI2C(second);
+        i2c.init();
+        mm::BME280<mm::BME280I2C> indoor(mm::BME280I2C(i2c, 0x76), 0);
+        mm::BME280<mm::BME280I2C> outdoor(mm::BME280I2C(i2c, 0x77), 1);
+        bme280InvalidateCalibrationCache(0);
+        bme280InvalidateCalibrationCache(1);
+
+        uint64_t start = mm::sim::cycles();
+        check(indoor.init(), "BME280 init");
+        row("BME280 init over I2C, calibration from sensor", mm::sim::cycles() - start, 0);
+        check(outdoor.init(), "BME280 init of the second sensor");
+        start = mm::sim::cycles();
+        check(indoor.init(), "BME280 init from cache");
+        row("BME280 init over I2C, calibration from cache", mm::sim::cycles() - start, 0);
+
+        // Another part at the same address and slot: the cached calibration must not be used
+        sensor.setCalibration(0x88, 0x71);
+        check(indoor.init() && indoor.calibration().dig_T1 == 0x6B71, "BME280 replaced sensor");
+        sensor.setCalibration(0x88, 0x70);
+        check(indoor.init() && indoor.calibration().dig_T1 == 0x6B70, "BME280 original sensor");
+
+        start = mm::sim::cycles();
+        check(indoor.readRawData(), "BME280 readRawData");
+        row("BME280 readRawData over I2C, 400 kHz", mm::sim::cycles() - start, 8);
+        checkReadings(indoor, "BME280 readings over I2C");
+        check(outdoor.readRawData(), "BME280 readRawData of the second sensor");
+        checkReadings(outdoor, "BME280 readings of the second sensor");
+        check(sensor.measurementCount() > 0 && second.measurementCount() > 0, "BME280 measurement");
+
+        // The driver's measurement time agrees with the simulated sensor for every oversampling
+        bool times_match = true;
+        for (uint8_t t = 0; t <= 5; t++)
+        {
+            for (uint8_t p = 0; p <= 5; p++)
+            {
+                for (uint8_t h = 0; h <= 5; h++)
+                {
+                    mm::BME280Settings settings =
+                        mm::bme280Settings(mm::BME280Mode::Forced, (mm::BME280Oversampling)t,
+                                           (mm::BME280Oversampling)p, (mm::BME280Oversampling)h);
+                    times_match = times_match && mm::bme280MeasurementTime(settings) ==
+                                                     mm::sim::BME280Sim::measurementTime(settings.ctrl_hum,
+                                                                                         settings.ctrl_meas);
+                }
+            }
+        }
+        check(times_match, "BME280 measurement time");
+
+        // Forced mode: the measurement ends within the datasheet's maximum time
+        check(outdoor.init(mm::bme280Settings(mm::BME280Mode::Forced)), "BME280 init in forced mode");
+        uint32_t count = second.measurementCount();
+        start = mm::sim::cycles();
+        check(outdoor.measure(), "BME280 measure");
+        uint64_t cycles = mm::sim::cycles() - start;
+        row("BME280 measure in forced mode over I2C", cycles, 8);
+        printf("  maximum measurement time %lu us\n", (unsigned long)outdoor.measurementTime());
+        check(second.measurementCount() == count + 1 &&
+                  mm::sim::microseconds(cycles) < outdoor.measurementTime() + 2 * BME280_POLL_INTERVAL_US,
+              "BME280 forced measurement");
+        checkReadings(outdoor, "BME280 readings in forced mode");
+
+        // A status read that fails must not be taken for a finished measurement
+        DroppingTarget dropping(second, 1);
+        mm::sim::reset();
+        mm::sim::attachI2C(dropping);
+        i2c.init();
+        check(!outdoor.measure() && dropping.addressed() == 2, "BME280 measure with a failed status read");
+
+        mm::SPIBus bus;
+        mm::SPIDevice device(bus, DDRB, PORTB, PB2, mm::spiSettings(F_CPU, 10000000UL, mm::SPIMode::Mode0));
+        mm::BME280<mm::BME280SPI> remote{mm::BME280SPI(device), 2};
+        bme280InvalidateCalibrationCache(2);
+        setup(sensor);
+        bus.init();
+        check(remote.init(), "BME280 init over SPI");
+        start = mm::sim::cycles();
+        check(remote.readRawData(), "BME280 readRawData over SPI");
+        row("BME280 readRawData over SPI, 8 MHz", mm::sim::cycles() - start, 8);
+        checkReadings(remote, "BME280 readings over SPI");
+    }
+
+    /**
+     * @brief Times one compensation kernel on the host CPU.
+     */
+    template <typename Kernel>
+    void benchKernel(const char *name, Kernel kernel)
+    {
+        const int32_t runs = 1 << 20;
+        volatile uint32_t sink = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < runs; i++)
+        {
+            sink = sink + kernel(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / runs;
+        printf("%-44s %10.2f ns (host)\n", name, ns);
+    }
+
+    void benchCompensation()
+    {
+        mm::sim::BME280Sim sensor;
+
+        setup(sensor);
+        i2c.init();
+        mm::BME280<mm::BME280I2C> bme280(mm::BME280I2C(i2c, 0x76), BME280_CACHE_SLOTS);
+        check(bme280.init() && bme280.readRawData(), "BME280 for the kernels");
+        static BME280_CalibData calib;
+        static int32_t t_fine;
+        calib = bme280.calibration();
+        t_fine = bme280.fineTemperature();
+
+        benchKernel("bme280FineTemperature", [](int32_t i)
+                    { return (uint32_t)bme280Temperature(bme280FineTemperature(calib, 400000 + (i & 0x3FFFF))); });
+        benchKernel("bme280PressureInt64", [](int32_t i)
+                    { return bme280PressureInt64(calib, t_fine, 300000 + (i & 0x3FFFF)); });
+        benchKernel("bme280PressureInt32", [](int32_t i)
+                    { return bme280PressureInt32(calib, t_fine, 300000 + (i & 0x3FFFF)); });
+        benchKernel("bme280Humidity", [](int32_t i)
+                    { return bme280Humidity(calib, t_fine, 20000 + (i & 0x7FFF)); });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        results = fopen(argv[1], "w");
+        if (!results)
+        {
+            perror(argv[1]);
+            return EXIT_FAILURE;
+        }
+        fprintf(results, "operation,cycles,us,bytes_per_s\n");
+    }
+
+    printf("Simulated ATmega328P at %lu MHz\n\n", (unsigned long)(F_CPU / 1000000UL));
+    benchUart();
+    benchI2C();
+    benchSPI();
+    benchSensor();
+    benchCompensation();
+
+    if (results)
+    {
+        fclose(results);
+    }
+    if (failures)
+    {
+        printf("\n%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file compensation_check.cpp
+ * @brief Checks the BME280 compensation kernels against the reference formulas.
+ *
+ * The temperature, humidity and 64-bit pressure kernels of lib/BME280/src/bme280_compensation.h must
+ * match the formulas of the Bosch datasheet bit for bit. The 32-bit pressure kernel must
+ * stay within BME280_PRESSURE_INT32_TOLERANCE_PA of the 64-bit one. Each check runs over
+ * the full range of the raw value, for several sets of calibration coefficients and for
+ * temperatures from -40 to 85 C. The program exits with a non-zero status on a mismatch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bme280_compensation.h"
+
+namespace
+{
+    constexpr int32_t t_fine_min = -40 * 5120; ///< Fine temperature at -40 C.
+    constexpr int32_t t_fine_max = 85 * 5120;  ///< Fine temperature at 85 C.
+    constexpr uint32_t pressure_min = 30000;   ///< Lower end of the operating range, Pa.
+    constexpr uint32_t pressure_max = 110000;  ///< Upper end of the operating range, Pa.
+
+    // Reference formulas, as in the datasheet and the previous version of sensor.h
+
+    int32_t referenceT(const BME280_CalibData &calib, int32_t adc_T, int32_t &t_fine)
+    {
+        int32_t var1, var2;
+        var1 = ((((adc_T >> 3) - ((int32_t)calib.dig_T1 << 1))) * ((int32_t)calib.dig_T2)) >> 11;
+        var2 = (((((adc_T >> 4) - ((int32_t)calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)calib.dig_T1))) >> 12) *
+                ((int32_t)calib.dig_T3)) >> 14;
+        t_fine = var1 + var2;
+        return (t_fine * 5 + 128) >> 8;
+    }
+
+    uint32_t referenceP(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_P)
+    {
+        int64_t var1, var2, p;
+        var1 = ((int64_t)t_fine) - 128000;
+        var2 = var1 * var1 * (int64_t)calib.dig_P6;
+        var2 = var2 + ((var1 * (int64_t)calib.dig_P5) << 17);
+        var2 = var2 + (((int64_t)calib.dig_P4) << 35);
+        var1 = ((var1 * var1 * (int64_t)calib.dig_P3) >> 8) + ((var1 * (int64_t)calib.dig_P2) << 12);
+        var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib.dig_P1) >> 33;
+        if (var1 == 0)
+        {
+            return 0;
+        }
+        p = 1048576 - adc_P;
+        p = (((p << 31) - var2) * 3125) / var1;
+        var1 = (((int64_t)calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+        var2 = (((int64_t)calib.dig_P8) * p) >> 19;
+        p = ((p + var1 + var2) >> 8) + (((int64_t)calib.dig_P7) << 4);
+        return (uint32_t)p;
+    }
+
+    uint32_t referenceH(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_H)
+    {
+        int32_t v_x1_u32r;
+        v_x1_u32r = (t_fine - ((int32_t)76800));
+        v_x1_u32r = (((((adc_H << 14) - (((int32_t)calib.dig_H4) << 20) - (((int32_t)calib.dig_H5) * v_x1_u32r)) +
+                    ((int32_t)16384)) >> 15) * (((((((v_x1_u32r * ((int32_t)calib.dig_H6)) >> 10) * (((v_x1_u32r *
+                    ((int32_t)calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) + ((int32_t)2097152)) *
+                    ((int32_t)calib.dig_H2) + 8192) >> 14));
+        v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)calib.dig_H1)) >> 4));
+        v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+        v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+        return (uint32_t)(v_x1_u32r >> 12);
+    }
+
+    /**
+     * @brief Calibration sets: the datasheet example and variations of it.
+     *
+     * Sets 4 to 6 exercise the humidity terms that are zero in the datasheet example:
+     * typical non-zero dig_H3 and dig_H6, and the extremes of every humidity field
+     * (dig_H1 and dig_H3 are 8-bit unsigned, dig_H4 and dig_H5 12-bit signed, dig_H6
+     * 8-bit signed). Set 6 also takes the temperature fields to their limits.
+     */
+    const BME280_CalibData calibrations[] = {
+        {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000, 75, 0, 362, 313, 50, 30},
+        {28145, 26524, 50, 37844, -10625, 3024, 8213, -166, -7, 9900, -10230, 4285, 75, 0, 370, 305, 0, 30},
+        {27236, 26947, -1000, 38341, -10585, 3024, 5846, 32, -7, 12300, -12000, 5000, 75, 0, 352, 333, 50, 30},
+        {26435, 25600, -500, 35000, -11000, 3500, 4000, 100, -5, 14000, -13000, 5500, 80, 10, 380, 290, 40, 25},
+        {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000, 75, 30, 350, 330, 50, 30},
+        {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000, 255, 255, 1023, 2047, -2048, 127},
+        {65535, 32767, -32768, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000, 0, 255, -1024, -2048, 2047, -128},
+    };
+
+    int failures = 0;
+
+    void fail(const char *kernel, int set, int32_t t_fine, int32_t adc, long long expected, long long actual)
+    {
+        if (failures++ < 10)
+        {
+            printf("FAILED %s: set %d, t_fine %ld, adc %ld: expected %lld, got %lld\n", kernel, set, (long)t_fine,
+                   (long)adc, expected, actual);
+        }
+    }
+
+    void checkTemperature(int set, const BME280_CalibData &calib)
+    {
+        for (int32_t adc = 0; adc < (1L << 20); adc++)
+        {
+            int32_t expected_fine;
+            int32_t expected = referenceT(calib, adc, expected_fine);
+            int32_t fine = bme280FineTemperature(calib, adc);
+            if (fine != expected_fine || bme280Temperature(fine) != expected)
+            {
+                fail("temperature", set, 0, adc, expected_fine, fine);
+            }
+        }
+    }
+
+    void checkHumidity(int set, const BME280_CalibData &calib)
+    {
+        for (int32_t t_fine = t_fine_min; t_fine <= t_fine_max; t_fine += 512)
+        {
+            for (int32_t adc = 0; adc < (1L << 16); adc++)
+            {
+                uint32_t expected = referenceH(calib, t_fine, adc);
+                uint32_t actual = bme280Humidity(calib, t_fine, adc);
+                if (actual != expected)
+                {
+                    fail("humidity", set, t_fine, adc, expected, actual);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Checks both pressure kernels.
+     *
+     * @return The largest difference of the 32-bit kernel from the 64-bit one, in Pa.
+     */
+    double checkPressure(int set, const BME280_CalibData &calib)
+    {
+        double worst = 0;
+
+        for (int32_t t_fine = t_fine_min; t_fine <= t_fine_max; t_fine += 5 * 5120)
+        {
+            for (int32_t adc = 0; adc < (1L << 20); adc++)
+            {
+                uint32_t expected = referenceP(calib, t_fine, adc);
+                uint32_t actual = bme280PressureInt64(calib, t_fine, adc);
+                if (actual != expected)
+                {
+                    fail("pressure int64", set, t_fine, adc, expected, actual);
+                }
+
+                // The 32-bit kernel only has to be accurate where the sensor works
+                double pascal = expected / 256.0;
+                if (pascal < pressure_min || pascal > pressure_max)
+                {
+                    continue;
+                }
+                double error = (double)bme280PressureInt32(calib, t_fine, adc) - pascal;
+                error = error < 0 ? -error : error;
+                if (error > worst)
+                {
+                    worst = error;
+                }
+                if (error > BME280_PRESSURE_INT32_TOLERANCE_PA)
+                {
+                    fail("pressure int32", set, t_fine, adc, expected / 256, bme280PressureInt32(calib, t_fine, adc));
+                }
+            }
+        }
+        return worst;
+    }
+}
+
+int main()
+{
+    const int sets = sizeof(calibrations) / sizeof(calibrations[0]);
+
+    for (int set = 0; set < sets; set++)
+    {
+        checkTemperature(set, calibrations[set]);
+        checkHumidity(set, calibrations[set]);
+        double worst = checkPressure(set, calibrations[set]);
+        printf("calibration set %d: T, H and P (int64) bit-exact, P (int32) within %.2f Pa\n", set, worst);
+    }
+
+    if (failures)
+    {
+        printf("%d mismatch(es)\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all kernels within tolerance (%d Pa for the 32-bit pressure kernel)\n", BME280_PRESSURE_INT32_TOLERANCE_PA);
+    return EXIT_SUCCESS;
+}
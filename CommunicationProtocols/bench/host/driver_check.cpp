@@ -0,0 +1,683 @@
+/**
+ * @file driver_check.cpp
+ * @brief Pass/fail tests of the drivers on the host register simulator.
+ *
+ * bench_host measures the normal transfers; this program checks what happens around
+ * them: UART reception with its overflow counters and the full transmit buffer policies,
+ * I2C NACKs, the recovery of a stuck bus and the transaction queue, the I2C and SPI slaves
+ * driven by a simulated external master, the scheduler and the telemetry framing. Each
+ * check prints one line, and the program exits with a non-zero status if any of them fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/interrupt.h>
+#include "AvrSim.h"
+#include "BME280Sim.h"
+#include "communication.h"
+#include "Scheduler.h"
+#include "Tick.h"
+
+namespace
+{
+    int failures = 0;
+
+    constexpr uint32_t uart_speed = 57600;
+    constexpr uint8_t sensor_address = 0x76;
+    constexpr uint8_t absent_address = 0x50;
+
+    /**
+     * @brief Prints the result of one check and records a failure.
+     */
+    void check(bool condition, const char *what)
+    {
+        printf("%-4s %s\n", condition ? "ok" : "FAIL", what);
+        if (!condition)
+        {
+            failures++;
+        }
+    }
+
+    /**
+     * @brief Lets simulated time pass.
+     */
+    void waitMs(uint32_t ms)
+    {
+        mm::sim::advance(ms * (F_CPU / 1000));
+    }
+
+    /**
+     * @brief Starts a test from a clean simulator with interrupts disabled.
+     */
+    void setup()
+    {
+        cli();
+        mm::sim::reset();
+    }
+
+    // ---- UART ----
+
+    void checkUartReceive()
+    {
+        typedef mm::StaticUART<0, mm::UARTMode::Interrupt> Uart;
+        static const uint8_t line[] = {'p', '2', '5', '0', '\n'};
+        uint8_t data[80];
+
+        setup();
+        Uart uart(uart_speed);
+        uart.init();
+        sei();
+        mm::sim::uartInject(line, sizeof(line));
+        waitMs(2);
+        uint8_t count = 0;
+        while (count < sizeof(data) && uart.tryReceiveByte(data[count]))
+        {
+            count++;
+        }
+        mm::UARTErrorCounters errors = uart.errorCounters();
+        check(count == sizeof(line) && memcmp(data, line, sizeof(line)) == 0, "UART interrupt receive");
+        check(errors.data_overrun == 0 && errors.buffer_overflow == 0 && errors.frame_error == 0,
+              "UART no receive errors");
+
+        // Nobody reads: the ring buffer fills and the rest is counted as overflow
+        for (uint8_t i = 0; i < sizeof(data); i++)
+        {
+            data[i] = i;
+        }
+        mm::sim::uartInject(data, UART_RX_BUFFER_SIZE + 6);
+        waitMs(20);
+        errors = uart.errorCounters();
+        check(uart.available() == UART_RX_BUFFER_SIZE && errors.buffer_overflow == 6,
+              "UART receive buffer overflow counted");
+        bool in_order = true;
+        for (uint8_t i = 0; i < UART_RX_BUFFER_SIZE; i++)
+        {
+            in_order = in_order && uart.receiveByte() == i;
+        }
+        check(in_order && uart.available() == 0, "UART keeps the oldest bytes on overflow");
+        uart.clearErrorCounters();
+        check(uart.errorCounters().buffer_overflow == 0, "UART clearErrorCounters");
+
+        // With interrupts disabled the hardware FIFO holds two bytes, the rest overruns
+        cli();
+        mm::sim::uartInject(line, 4);
+        waitMs(2);
+        sei();
+        errors = uart.errorCounters();
+        check(errors.data_overrun > 0 && uart.available() == 2 && uart.receiveByte() == 'p' &&
+                  uart.receiveByte() == '2',
+              "UART hardware overrun counted");
+        cli();
+
+        // Polling mode through the runtime class
+        setup();
+        mm::UART polled(0, uart_speed);
+        polled.init();
+        mm::sim::uartInject(line, 2);
+        check(polled.receiveByte() == 'p' && polled.receiveByte() == '2' && polled.available() == 0,
+              "UART polling receive");
+    }
+
+    /**
+     * @brief Queues 100 bytes with interrupts disabled and sends them afterwards.
+     *
+     * @return The number of bytes the policy discarded.
+     */
+    template <typename Uart>
+    uint16_t fillTransmitBuffer(Uart &uart)
+    {
+        uart.init();
+        for (uint8_t i = 0; i < 100; i++)
+        {
+            uart.transmitByte(i);
+        }
+        sei();
+        uart.flush();
+        cli();
+        return uart.droppedBytes();
+    }
+
+    /**
+     * @brief Checks that the USART sent `count` consecutive bytes starting at `first`.
+     */
+    bool sent(uint8_t first, uint8_t count)
+    {
+        const std::vector<uint8_t> &output = mm::sim::uartOutput();
+        bool match = output.size() == count;
+        for (uint8_t i = 0; match && i < count; i++)
+        {
+            match = output[i] == (uint8_t)(first + i);
+        }
+        return match;
+    }
+
+    void checkUartTransmitPolicies()
+    {
+        typedef mm::StaticUART<0, mm::UARTMode::Interrupt> Uart;
+        constexpr uint8_t kept = UART_TX_BUFFER_SIZE;
+
+        setup();
+        Uart drop(uart_speed, mm::TxFullPolicy::Drop);
+        uint16_t dropped = fillTransmitBuffer(drop);
+        check(dropped == 100 - kept && sent(0, kept), "UART Drop keeps the oldest bytes");
+
+        setup();
+        Uart overwrite(uart_speed, mm::TxFullPolicy::Overwrite);
+        dropped = fillTransmitBuffer(overwrite);
+        check(dropped == 100 - kept && sent(100 - kept, kept), "UART Overwrite keeps the newest bytes");
+
+        // Block with interrupts disabled sends by hand instead of waiting forever
+        setup();
+        Uart block(uart_speed, mm::TxFullPolicy::Block);
+        dropped = fillTransmitBuffer(block);
+        check(dropped == 0 && sent(0, 100), "UART Block loses nothing");
+    }
+
+    // ---- I2C master ----
+
+    /**
+     * @brief A device that acknowledges its address and the first data byte only.
+     */
+    class NackingTarget : public mm::sim::I2CTarget
+    {
+    private:
+        uint8_t received;
+
+    public:
+        NackingTarget() : received(0) {}
+
+        uint8_t address() const override { return 0x42; }
+        void start(bool) override { received = 0; }
+        bool write(uint8_t) override { return ++received < 2; }
+        uint8_t read(bool) override { return 0; }
+        void stop() override {}
+    };
+
+    void checkI2CErrors()
+    {
+        mm::sim::BME280Sim sensor;
+        NackingTarget nacking;
+        mm::I2C bus(mm::Hz(400000UL));
+        uint8_t data = 0;
+
+        setup();
+        mm::sim::attachI2C(sensor);
+        mm::sim::attachI2C(nacking);
+        bus.init();
+
+        check(bus.read_register(absent_address, 0xD0, data) == mm::I2CStatus::AddressNack,
+              "I2C address NACK");
+        check(bus.read_register(sensor_address, 0xD0, data) == mm::I2CStatus::Ok && data == 0x60,
+              "I2C usable after an address NACK");
+
+        uint8_t block[3] = {1, 2, 3};
+        check(bus.write_block(0x42, 0x10, block, sizeof(block)) == mm::I2CStatus::DataNack, "I2C data NACK");
+        check(bus.read_register(sensor_address, 0xD0, data) == mm::I2CStatus::Ok && data == 0x60,
+              "I2C usable after a data NACK");
+
+        sei();
+        uint8_t reg = 0xD0;
+        mm::I2CTransaction transaction = {absent_address, &reg, 1, &data, 1, nullptr, nullptr, mm::I2CStatus::Ok};
+        bus.submit(transaction);
+        check(bus.wait(transaction) == mm::I2CStatus::AddressNack && !bus.isBusy(), "I2C submit address NACK");
+        cli();
+    }
+
+    void checkBusRecovery()
+    {
+        mm::sim::BME280Sim sensor;
+        mm::I2C bus(mm::Hz(400000UL));
+        uint8_t data = 0;
+
+        setup();
+        mm::sim::attachI2C(sensor);
+        bus.init();
+
+        // A slave still drives a 0 bit: START cannot be sent, the bus is recovered
+        mm::sim::holdSDA(5);
+        check(bus.read_register(sensor_address, 0xD0, data) == mm::I2CStatus::Timeout, "I2C timeout on a stuck bus");
+        check(bus.read_register(sensor_address, 0xD0, data) == mm::I2CStatus::Ok && data == 0x60,
+              "I2C usable after the automatic recovery");
+
+        mm::sim::holdSDA(0xFF);
+        check(bus.recover_bus() == mm::I2CStatus::BusError, "I2C recover_bus reports a bus that stays stuck");
+        mm::sim::holdSDA(9);
+        check(bus.recover_bus() == mm::I2CStatus::Ok, "I2C recover_bus frees SDA within 9 clocks");
+        check(TWBR == mm::i2cClock(F_CPU, 400000UL).twbr && (TWCR & (1 << TWEN)), "I2C recover_bus restores the TWI");
+        check(bus.read_register(sensor_address, 0xD0, data) == mm::I2CStatus::Ok && data == 0x60,
+              "I2C usable after recover_bus");
+    }
+
+    // ---- I2C transaction queue ----
+
+    mm::I2CTransaction queued_transactions[2 * I2C_QUEUE_SIZE];
+    uint8_t queued_data[2 * I2C_QUEUE_SIZE];
+    uint8_t completed[2 * I2C_QUEUE_SIZE];
+    uint8_t completed_length;
+    uint8_t follow_ups;
+    mm::I2C *queue_bus;
+
+    const uint8_t chip_id_register = 0xD0;
+
+    /**
+     * @brief Records the index of a finished transaction.
+     */
+    void recordCompletion(mm::I2CTransaction &transaction)
+    {
+        completed[completed_length++] = &transaction - queued_transactions;
+    }
+
+    /**
+     * @brief Records the transaction and submits the next one until `follow_ups` run out.
+     */
+    void submitFollowUp(mm::I2CTransaction &transaction)
+    {
+        recordCompletion(transaction);
+        if (follow_ups > 0)
+        {
+            follow_ups--;
+            queue_bus->submit(*(&transaction + 1));
+        }
+    }
+
+    /**
+     * @brief Prepares `queued_transactions[index]` to read the chip ID of `address`.
+     */
+    mm::I2CTransaction &chipIdRead(uint8_t index, uint8_t address, mm::I2CCallback callback)
+    {
+        queued_data[index] = 0;
+        queued_transactions[index] = {address, &chip_id_register, 1, &queued_data[index], 1, callback, nullptr,
+                                      mm::I2CStatus::Ok};
+        return queued_transactions[index];
+    }
+
+    /**
+     * @brief Checks that transactions `0` to `count - 1` read the chip ID in order.
+     */
+    bool completedInOrder(uint8_t count)
+    {
+        bool match = completed_length == count;
+        for (uint8_t i = 0; match && i < count; i++)
+        {
+            match = completed[i] == i && queued_transactions[i].status == mm::I2CStatus::Ok && queued_data[i] == 0x60;
+        }
+        return match;
+    }
+
+    /**
+     * @brief Submits `count` chip ID reads with interrupts disabled, then runs them.
+     *
+     * The first one starts at once and the others wait in the queue until `sei()`.
+     *
+     * @return True if the queue held all but the first and they completed in order.
+     */
+    bool runBatch(mm::I2C &bus, uint8_t count)
+    {
+        bool accepted = true;
+
+        completed_length = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            accepted = bus.submit(chipIdRead(i, sensor_address, recordCompletion)) && accepted;
+        }
+        bool queued = bus.queued() == count - 1;
+        sei();
+        bus.wait(queued_transactions[count - 1]);
+        cli();
+        return accepted && queued && completedInOrder(count) && !bus.isBusy();
+    }
+
+    void checkI2CQueue()
+    {
+        mm::sim::BME280Sim sensor;
+        NackingTarget nacking;
+        mm::I2C bus(mm::Hz(400000UL));
+
+        setup();
+        mm::sim::attachI2C(sensor);
+        mm::sim::attachI2C(nacking);
+        bus.init();
+        queue_bus = &bus;
+
+        // A full queue rejects the next transaction and leaves the queued ones alone
+        completed_length = 0;
+        bool accepted = true;
+        for (uint8_t i = 0; i <= I2C_QUEUE_SIZE; i++)
+        {
+            accepted = bus.submit(chipIdRead(i, sensor_address, recordCompletion)) && accepted;
+        }
+        bool rejected = !bus.submit(chipIdRead(I2C_QUEUE_SIZE + 1, sensor_address, recordCompletion));
+        check(accepted && rejected && bus.queued() == I2C_QUEUE_SIZE, "I2C queue full rejects submit()");
+        sei();
+        bus.wait(queued_transactions[I2C_QUEUE_SIZE]);
+        cli();
+        check(completedInOrder(I2C_QUEUE_SIZE + 1) && !bus.isBusy(), "I2C queue runs in submission order");
+
+        // Batches that do not divide the queue size move the ring indices across its end
+        bool wrapped = true;
+        for (uint8_t round = 0; round < 3; round++)
+        {
+            wrapped = runBatch(bus, I2C_QUEUE_SIZE - 2) && runBatch(bus, I2C_QUEUE_SIZE + 1) && wrapped;
+        }
+        check(wrapped, "I2C queue wraps around its ring buffer");
+
+        // Each callback submits the next transaction from interrupt context
+        completed_length = 0;
+        follow_ups = 2 * I2C_QUEUE_SIZE - 1;
+        for (uint8_t i = 0; i < 2 * I2C_QUEUE_SIZE; i++)
+        {
+            chipIdRead(i, sensor_address, submitFollowUp);
+        }
+        sei();
+        bus.submit(queued_transactions[0]);
+        for (uint8_t i = 0; i < 2 * I2C_QUEUE_SIZE; i++)
+        {
+            bus.wait(queued_transactions[i]);
+        }
+        cli();
+        check(completedInOrder(2 * I2C_QUEUE_SIZE) && follow_ups == 0 && !bus.isBusy(),
+              "I2C callbacks submit follow-up transactions");
+
+        // Failed transactions end with their own status and the next queued one still runs
+        completed_length = 0;
+        static const uint8_t block[] = {0x10, 1, 2};
+        bus.submit(chipIdRead(0, absent_address, recordCompletion));
+        bus.submit(queued_transactions[1] = {0x42, block, sizeof(block), nullptr, 0, recordCompletion, nullptr,
+                                             mm::I2CStatus::Ok});
+        bus.submit(chipIdRead(2, sensor_address, recordCompletion));
+        sei();
+        bus.wait(queued_transactions[2]);
+        cli();
+        check(completed_length == 3 && queued_transactions[0].status == mm::I2CStatus::AddressNack &&
+                  queued_transactions[1].status == mm::I2CStatus::DataNack &&
+                  queued_transactions[2].status == mm::I2CStatus::Ok && queued_data[2] == 0x60,
+              "I2C queue continues after failed transactions");
+    }
+
+    // ---- I2C slave ----
+
+    uint8_t general_call_data;
+
+    bool protectRegisterZero(uint8_t reg, uint8_t)
+    {
+        return reg != 0;
+    }
+
+    void recordGeneralCall(uint8_t data)
+    {
+        general_call_data = data;
+    }
+
+    void checkI2CSlave()
+    {
+        uint8_t registers[8] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17};
+        uint8_t data[3];
+
+        setup();
+        mm::I2CSlave slave(0x30, registers, sizeof(registers), true);
+        slave.init();
+        sei();
+
+        const uint8_t write[] = {2, 0xA0, 0xA1};
+        check(mm::sim::i2cMasterWrite(0x30, write, sizeof(write)) && registers[2] == 0xA0 && registers[3] == 0xA1,
+              "I2C slave register write");
+
+        const uint8_t pointer[] = {2};
+        check(mm::sim::i2cMasterWrite(0x30, pointer, 1) && mm::sim::i2cMasterRead(0x30, data, 3) &&
+                  data[0] == 0xA0 && data[1] == 0xA1 && data[2] == 0x14,
+              "I2C slave register read with auto-increment");
+
+        const uint8_t last[] = {7};
+        check(mm::sim::i2cMasterWrite(0x30, last, 1) && mm::sim::i2cMasterRead(0x30, data, 3) &&
+                  data[0] == 0x17 && data[1] == I2C_SLAVE_IDLE_BYTE && data[2] == I2C_SLAVE_IDLE_BYTE,
+              "I2C slave read past the register map");
+
+        slave.setWriteHook(protectRegisterZero);
+        const uint8_t protect[] = {0, 0x55, 0x66};
+        check(mm::sim::i2cMasterWrite(0x30, protect, sizeof(protect)) && registers[0] == 0x10 && registers[1] == 0x66,
+              "I2C slave write hook");
+        slave.setWriteHook(nullptr);
+
+        slave.setGeneralCallHook(recordGeneralCall);
+        const uint8_t reset_command[] = {0x06};
+        check(mm::sim::i2cMasterWrite(0, reset_command, 1) && general_call_data == 0x06, "I2C slave general call");
+
+        check(!mm::sim::i2cMasterWrite(0x31, write, sizeof(write)) && registers[2] == 0xA0,
+              "I2C slave ignores other addresses");
+
+        slave.end();
+        mm::I2CSlave masked(0x30, registers, sizeof(registers), false, 0x01);
+        masked.init();
+        check(mm::sim::i2cMasterRead(0x31, data, 1) && !mm::sim::i2cMasterWrite(0, reset_command, 1),
+              "I2C slave address mask");
+        masked.end();
+        check(TWCR == 0 && !mm::sim::i2cMasterRead(0x30, data, 1), "I2C slave end");
+        cli();
+    }
+
+    // ---- SPI slave ----
+
+    uint8_t respond(uint8_t index, uint8_t)
+    {
+        return 0x40 + index;
+    }
+
+    /**
+     * @brief Sends one frame from the external master, framed by SS.
+     */
+    void spiFrame(const uint8_t *tx, uint8_t *rx, uint8_t len)
+    {
+        mm::sim::drivePin(PINB, PB2, true);
+        for (uint8_t i = 0; i < len; i++)
+        {
+            uint8_t in = mm::sim::spiMasterTransfer(tx[i]);
+            if (rx)
+            {
+                rx[i] = in;
+            }
+        }
+        mm::sim::drivePin(PINB, PB2, false);
+    }
+
+    void checkSPISlave()
+    {
+        uint8_t tx[SPI_SLAVE_RX_BUFFER_SIZE + 8];
+        uint8_t rx[sizeof(tx)];
+        uint8_t frame[8];
+
+        for (uint8_t i = 0; i < sizeof(tx); i++)
+        {
+            tx[i] = i + 1;
+        }
+
+        setup();
+        mm::SPISlave slave;
+        slave.init();
+        sei();
+
+        slave.write(0xA5);
+        slave.write(0x5A);
+        spiFrame(tx, rx, 3);
+        check(rx[0] == SPI_SLAVE_IDLE_BYTE && rx[1] == 0xA5 && rx[2] == 0x5A, "SPI slave sends queued bytes");
+        check(slave.framesAvailable() == 1 && slave.readFrame(frame, sizeof(frame)) == 3 && frame[0] == 1 &&
+                  frame[1] == 2 && frame[2] == 3,
+              "SPI slave receives a frame");
+
+        check(mm::sim::spiMasterTransfer(0x77) == 0xFF && slave.available() == 0, "SPI slave ignores the clock without SS");
+
+        // A frame larger than the receive buffer is dropped whole
+        spiFrame(tx, nullptr, sizeof(tx));
+        check(slave.framesAvailable() == 0 && slave.available() == 0 && slave.errorCounters().buffer_overflow == 1,
+              "SPI slave drops an oversized frame");
+        spiFrame(tx, nullptr, 2);
+        check(slave.readFrame(frame, sizeof(frame)) == 2 && frame[0] == 1 && frame[1] == 2,
+              "SPI slave receives after an overflow");
+
+        slave.setResponder(respond);
+        spiFrame(tx, rx, 3);
+        check(rx[0] == SPI_SLAVE_IDLE_BYTE && rx[1] == 0x40 && rx[2] == 0x41 && slave.framesAvailable() == 0,
+              "SPI slave responder");
+        slave.setResponder(nullptr);
+        cli();
+        SPCR = 0;
+        PCICR = 0;
+    }
+
+    // ---- Scheduler ----
+
+    char order[8];
+    uint8_t order_length;
+    uint32_t triggered_at;
+
+    void countRun(void *context)
+    {
+        (*(uint16_t *)context)++;
+    }
+
+    void recordRun(void *context)
+    {
+        if (order_length < sizeof(order))
+        {
+            order[order_length++] = *(const char *)context;
+        }
+    }
+
+    void recordTrigger(void *)
+    {
+        triggered_at = mm::millis();
+    }
+
+    void overrun(void *)
+    {
+        waitMs(25);
+    }
+
+    /**
+     * @brief Runs the scheduler for a number of ticks.
+     */
+    void runFor(mm::Scheduler &scheduler, uint32_t ticks)
+    {
+        uint32_t end = mm::millis() + ticks;
+        while (mm::millis() < end)
+        {
+            if (!scheduler.runOnce())
+            {
+                mm::sim::advance(F_CPU / 10000);
+            }
+        }
+    }
+
+    void checkScheduler()
+    {
+        setup();
+        mm::initTick();
+        sei();
+
+        mm::Scheduler scheduler;
+        uint16_t periodic_runs = 0;
+        uint16_t triggered_runs = 0;
+        uint8_t periodic = scheduler.addTask(countRun, 10, 0, 0, &periodic_runs);
+        uint8_t triggered = scheduler.addTask(recordTrigger, 0);
+        runFor(scheduler, 100);
+        check(periodic_runs == 10 && scheduler.statistics(periodic).runs == 10, "Scheduler periodic task");
+        check(scheduler.statistics(triggered).runs == 0, "Scheduler task with period 0 waits for trigger()");
+
+        uint32_t now = mm::millis();
+        scheduler.trigger(triggered, 5);
+        runFor(scheduler, 20);
+        triggered_runs = scheduler.statistics(triggered).runs;
+        check(triggered_runs == 1 && triggered_at >= now + 5 && triggered_at <= now + 6, "Scheduler trigger() with delay");
+
+        scheduler.setPeriod(periodic, 20);
+        periodic_runs = 0;
+        runFor(scheduler, 100);
+        check(periodic_runs == 5, "Scheduler setPeriod()");
+        scheduler.setEnabled(periodic, false);
+        periodic_runs = 0;
+        runFor(scheduler, 50);
+        check(periodic_runs == 0, "Scheduler setEnabled(false)");
+
+        // Released together: the earlier deadline first, equal deadlines in the order added
+        mm::Scheduler edf;
+        static const char a = 'a', b = 'b', c = 'c';
+        edf.addTask(recordRun, 100, 50, 0, (void *)&a);
+        edf.addTask(recordRun, 100, 5, 0, (void *)&b);
+        edf.addTask(recordRun, 100, 50, 0, (void *)&c);
+        order_length = 0;
+        runFor(edf, 10);
+        check(order_length == 3 && memcmp(order, "bac", 3) == 0, "Scheduler earliest deadline first");
+
+        // A task that runs longer than its period misses deadlines and skips releases
+        mm::Scheduler late;
+        uint8_t slow = late.addTask(overrun, 10);
+        runFor(late, 100);
+        mm::TaskStatistics statistics = late.statistics(slow);
+        check(statistics.deadline_misses > 0 && statistics.skipped > 0 && statistics.runs < 10,
+              "Scheduler counts misses and skipped releases");
+        cli();
+    }
+
+    // ---- Telemetry ----
+
+    bool sameSample(const mm::TelemetrySample &a, const mm::TelemetrySample &b)
+    {
+        return a.sequence == b.sequence && a.timestamp == b.timestamp && a.temperature == b.temperature &&
+               a.pressure == b.pressure && a.humidity == b.humidity;
+    }
+
+    void checkTelemetry()
+    {
+        uint8_t frame[mm::telemetry::frame_size];
+        mm::TelemetrySample decoded;
+        const mm::TelemetrySample samples[] = {
+            {1234, 567890, -1234, 25767168, 5500},
+            {0, 0, 0, 0, 0},
+            {0xFFFF, 0xFFFFFFFF, -32768, 0xFFFFFFFF, 0xFFFF},
+        };
+
+        for (const mm::TelemetrySample &sample : samples)
+        {
+            uint8_t len = mm::encodeTelemetry(sample, frame);
+            bool delimited = len <= sizeof(frame) && frame[len - 1] == 0 && memchr(frame, 0, len - 1) == nullptr;
+            check(delimited && mm::decodeTelemetry(frame, len - 1, decoded) && sameSample(sample, decoded),
+                  "Telemetry frame round trip");
+        }
+
+        uint8_t len = mm::encodeTelemetry(samples[0], frame);
+        bool detected = true;
+        for (uint8_t i = 0; i < len - 1; i++)
+        {
+            for (uint8_t bit = 0; bit < 8; bit++)
+            {
+                frame[i] ^= 1 << bit;
+                detected = detected && !mm::decodeTelemetry(frame, len - 1, decoded);
+                frame[i] ^= 1 << bit;
+            }
+        }
+        check(detected, "Telemetry rejects every single bit error");
+        check(!mm::decodeTelemetry(frame, len - 2, decoded) && !mm::decodeTelemetry(frame, 0, decoded),
+              "Telemetry rejects a truncated frame");
+    }
+}
+
+int main()
+{
+    checkUartReceive();
+    checkUartTransmitPolicies();
+    checkI2CErrors();
+    checkBusRecovery();
+    checkI2CQueue();
+    checkI2CSlave();
+    checkSPISlave();
+    checkScheduler();
+    checkTelemetry();
+
+    if (failures)
+    {
+        printf("\n%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("\nall checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1092 @@
+#include "AvrSim.h"
+#include <avr/io.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+
+// Vectors defined with ISR() by the program; the missing ones resolve to null
+#define MM_SIM_VECTOR(n) extern "C" void __vector_##n(void) __attribute__((weak));
+MM_SIM_VECTOR(1)
+MM_SIM_VECTOR(2)
+MM_SIM_VECTOR(3)
+MM_SIM_VECTOR(4)
+MM_SIM_VECTOR(5)
+MM_SIM_VECTOR(6)
+MM_SIM_VECTOR(7)
+MM_SIM_VECTOR(8)
+MM_SIM_VECTOR(9)
+MM_SIM_VECTOR(10)
+MM_SIM_VECTOR(11)
+MM_SIM_VECTOR(12)
+MM_SIM_VECTOR(13)
+MM_SIM_VECTOR(14)
+MM_SIM_VECTOR(15)
+MM_SIM_VECTOR(16)
+MM_SIM_VECTOR(17)
+MM_SIM_VECTOR(18)
+MM_SIM_VECTOR(19)
+MM_SIM_VECTOR(20)
+MM_SIM_VECTOR(21)
+MM_SIM_VECTOR(22)
+MM_SIM_VECTOR(23)
+MM_SIM_VECTOR(24)
+MM_SIM_VECTOR(25)
+#undef MM_SIM_VECTOR
+
+mm::sim::Register mm::sim::io[256];
+
+namespace
+{
+    constexpr uint64_t never = UINT64_MAX;
+
+    // Data space addresses of the simulated registers
+    namespace reg
+    {
+        constexpr uint8_t pinb = 0x23, ddrb = 0x24, portb = 0x25;
+        constexpr uint8_t pinc = 0x26, ddrc = 0x27, portc = 0x28;
+        constexpr uint8_t pind = 0x29, ddrd = 0x2A, portd = 0x2B;
+        constexpr uint8_t tifr0 = 0x35, tifr1 = 0x36, tifr2 = 0x37, pcifr = 0x3B;
+        constexpr uint8_t tccr0a = 0x44, tccr0b = 0x45, tcnt0 = 0x46, ocr0a = 0x47;
+        constexpr uint8_t spcr = 0x4C, spsr = 0x4D, spdr = 0x4E;
+        constexpr uint8_t smcr = 0x53, sreg = 0x5F;
+        constexpr uint8_t pcicr = 0x68, pcmsk0 = 0x6B, timsk0 = 0x6E, timsk2 = 0x70;
+        constexpr uint8_t tccr2a = 0xB0, tccr2b = 0xB1, tcnt2 = 0xB2, ocr2a = 0xB3;
+        constexpr uint8_t twbr = 0xB8, twsr = 0xB9, twar = 0xBA, twdr = 0xBB, twcr = 0xBC, twamr = 0xBD;
+        constexpr uint8_t ucsr0a = 0xC0, ucsr0b = 0xC1, ucsr0c = 0xC2, ubrr0l = 0xC4, ubrr0h = 0xC5, udr0 = 0xC6;
+    }
+
+    /**
+     * @brief Time, register contents and interrupt state.
+     */
+    struct Core
+    {
+        uint64_t now;      ///< CPU cycles since reset.
+        uint8_t mem[256];  ///< Register contents.
+        bool in_interrupt; ///< Set while an ISR runs.
+    };
+
+    /**
+     * @brief Levels forced on the GPIO pins by the outside world.
+     */
+    struct Pins
+    {
+        uint8_t driven_low[3]; ///< Pins of port B, C and D pulled low externally.
+        uint8_t pinb;          ///< Last level of port B, for the pin change interrupt.
+        uint8_t sda_clocks;    ///< SCL pulses until a stuck slave releases SDA, 0xFF for never.
+    };
+
+    /**
+     * @brief USART0: a transmit shift register with a one-byte buffer and a two-byte receive FIFO.
+     */
+    struct Usart
+    {
+        bool tx_busy;                ///< A byte is being shifted out.
+        uint8_t tx_shift;            ///< The byte being shifted out.
+        bool tx_buffered;            ///< A byte waits in UDR for the shift register.
+        uint8_t tx_buffer;           ///< The waiting byte.
+        uint64_t tx_time;            ///< End of the current frame.
+        std::vector<uint8_t> output; ///< Every byte sent.
+        std::deque<uint8_t> rx_line; ///< Injected bytes not yet received.
+        uint64_t rx_time;            ///< Arrival of the next injected byte.
+        uint8_t rx_fifo[2];          ///< Received bytes not yet read from UDR.
+        uint8_t rx_count;            ///< Number of bytes in the FIFO.
+    };
+
+    /**
+     * @brief TWI master and the devices on the bus.
+     */
+    struct Twi
+    {
+        enum class Action : uint8_t
+        {
+            None,
+            StopDone,
+            Start,
+            Address,
+            Data
+        };
+
+        enum class Mode : uint8_t
+        {
+            None,
+            Transmit,
+            Receive
+        };
+
+        Action action;                            ///< Step in progress.
+        uint64_t time;                            ///< End of the step.
+        bool start_after_stop;                    ///< STOP and START were requested together.
+        bool bus_owned;                           ///< A START was sent and no STOP yet.
+        Mode mode;                                ///< Direction after the address was acknowledged.
+        mm::sim::I2CTarget *target;               ///< Addressed device.
+        std::vector<mm::sim::I2CTarget *> devices; ///< Devices on the bus.
+    };
+
+    /**
+     * @brief SPI master and the devices on the bus.
+     */
+    struct Spi
+    {
+        struct Device
+        {
+            mm::sim::SPITarget *target;
+            uint8_t port;  ///< Address of the PORT register of the chip select.
+            uint8_t mask;  ///< Bit of the chip select.
+            bool selected; ///< Chip select is low.
+        };
+
+        bool busy;                   ///< A byte is being shifted.
+        uint8_t tx;                  ///< The byte being sent.
+        uint8_t slave_tx;            ///< Byte the slave shifts out on the next external transfer.
+        uint8_t rx;                  ///< Read buffer of SPDR.
+        uint64_t time;               ///< End of the byte.
+        bool flag_read;              ///< SPSR was read with SPIF set; the next SPDR access clears it.
+        std::vector<Device> devices; ///< Devices on the bus.
+    };
+
+    /**
+     * @brief An 8-bit timer; only compare match A is simulated.
+     */
+    struct Timer
+    {
+        uint8_t tccra, tccrb, tcnt, ocra, tifr, timsk; ///< Register addresses.
+        bool timer2;                                    ///< Timer2 has its own prescaler table.
+        uint32_t prescaler;                             ///< Cycles per count, 0 when stopped.
+        uint64_t epoch;                                 ///< Time the counter was last zero.
+        uint64_t time;                                  ///< Next compare match.
+    };
+
+    Core core;
+    Pins pins;
+    Usart usart;
+    Twi twi;
+    Spi spi;
+    Timer timer0 = {reg::tccr0a, reg::tccr0b, reg::tcnt0, reg::ocr0a, reg::tifr0, reg::timsk0, false, 0, 0, never};
+    Timer timer2 = {reg::tccr2a, reg::tccr2b, reg::tcnt2, reg::ocr2a, reg::tifr2, reg::timsk2, true, 0, 0, never};
+
+    uint8_t &mem(uint8_t address)
+    {
+        return core.mem[address];
+    }
+
+    bool isSet(uint8_t address, uint8_t bit)
+    {
+        return core.mem[address] & (1 << bit);
+    }
+
+    // ---- GPIO ----
+
+    constexpr uint8_t sda_mask = 1 << 4; ///< PC4
+    constexpr uint8_t scl_mask = 1 << 5; ///< PC5
+
+    uint8_t pinLevel(uint8_t pin_address)
+    {
+        uint8_t ddr = mem(pin_address + 1);
+        uint8_t inputs = ~ddr & ~pins.driven_low[(pin_address - reg::pinb) / 3];
+        return (mem(pin_address + 2) & ddr) | inputs;
+    }
+
+    /**
+     * @brief Raises the pin change flag of port B when a pin enabled in PCMSK0 changed.
+     */
+    void updatePinChange()
+    {
+        uint8_t level = pinLevel(reg::pinb);
+        if ((level ^ pins.pinb) & mem(reg::pcmsk0))
+        {
+            mem(reg::pcifr) |= (1 << PCIF0);
+        }
+        pins.pinb = level;
+    }
+
+    /**
+     * @brief Counts SCL pulses generated by hand for a slave that holds SDA low.
+     *
+     * The pins are open drain: a line is low while its DDR bit is set.
+     */
+    void ddrcChanged(uint8_t old_ddr, uint8_t new_ddr)
+    {
+        if (!(pins.driven_low[1] & sda_mask) || pins.sda_clocks == 0xFF)
+        {
+            return;
+        }
+        if ((old_ddr & scl_mask) && !(new_ddr & scl_mask) && --pins.sda_clocks == 0)
+        {
+            pins.driven_low[1] &= ~sda_mask;
+        }
+    }
+
+    // ---- USART0 ----
+
+    uint64_t usartFrameCycles()
+    {
+        uint16_t ubrr = ((mem(reg::ubrr0h) & 0x0F) << 8) | mem(reg::ubrr0l);
+        uint8_t bits = 1 + 8 + (isSet(reg::ucsr0c, UPM01) ? 1 : 0) + (isSet(reg::ucsr0c, USBS0) ? 2 : 1);
+        return (uint64_t)bits * (isSet(reg::ucsr0a, U2X0) ? 8 : 16) * (ubrr + 1);
+    }
+
+    void usartWrite(uint8_t data)
+    {
+        if (!isSet(reg::ucsr0b, TXEN0))
+        {
+            return;
+        }
+
+        if (!usart.tx_busy)
+        {
+            usart.tx_busy = true;
+            usart.tx_shift = data;
+            usart.tx_time = core.now + usartFrameCycles();
+        }
+        else
+        {
+            // Writing a full UDR overwrites the waiting byte, as on the hardware
+            usart.tx_buffered = true;
+            usart.tx_buffer = data;
+            mem(reg::ucsr0a) &= ~(1 << UDRE0);
+        }
+    }
+
+    void usartTransmitted()
+    {
+        usart.output.push_back(usart.tx_shift);
+        if (usart.tx_buffered)
+        {
+            usart.tx_buffered = false;
+            usart.tx_shift = usart.tx_buffer;
+            usart.tx_time += usartFrameCycles();
+            mem(reg::ucsr0a) |= (1 << UDRE0);
+        }
+        else
+        {
+            usart.tx_busy = false;
+            mem(reg::ucsr0a) |= (1 << TXC0);
+        }
+    }
+
+    void usartReceived()
+    {
+        uint8_t data = usart.rx_line.front();
+        usart.rx_line.pop_front();
+        usart.rx_time = usart.rx_line.empty() ? never : usart.rx_time + usartFrameCycles();
+
+        if (!isSet(reg::ucsr0b, RXEN0))
+        {
+            return;
+        }
+        if (usart.rx_count < 2)
+        {
+            usart.rx_fifo[usart.rx_count++] = data;
+        }
+        else
+        {
+            mem(reg::ucsr0a) |= (1 << DOR0);
+        }
+        mem(reg::ucsr0a) |= (1 << RXC0);
+    }
+
+    uint8_t usartRead()
+    {
+        if (usart.rx_count == 0)
+        {
+            return mem(reg::udr0);
+        }
+
+        uint8_t data = usart.rx_fifo[0];
+        usart.rx_fifo[0] = usart.rx_fifo[1];
+        if (--usart.rx_count == 0)
+        {
+            mem(reg::ucsr0a) &= ~((1 << RXC0) | (1 << DOR0) | (1 << FE0));
+        }
+        mem(reg::udr0) = data;
+        return data;
+    }
+
+    // ---- TWI ----
+
+    uint64_t twiBitCycles()
+    {
+        return 16 + 2 * (uint64_t)mem(reg::twbr) * (1UL << (2 * (mem(reg::twsr) & 0x03)));
+    }
+
+    void twiStatus(uint8_t status)
+    {
+        mem(reg::twsr) = (mem(reg::twsr) & 0x03) | status;
+    }
+
+    void twiSchedule(Twi::Action action, uint8_t bits)
+    {
+        twi.action = action;
+        twi.time = core.now + bits * twiBitCycles();
+    }
+
+    void twiControl(uint8_t value)
+    {
+        uint8_t &twcr = mem(reg::twcr);
+        twcr = (twcr & (1 << TWINT)) | (value & ~((1 << TWINT) | (1 << TWWC)));
+
+        if (!(value & (1 << TWEN)))
+        {
+            twi.action = Twi::Action::None;
+            twi.time = never;
+            twi.bus_owned = false;
+            twi.mode = Twi::Mode::None;
+            twi.target = nullptr;
+            twcr &= ~(1 << TWINT);
+            return;
+        }
+
+        // Writing one to TWINT clears the flag and starts the next step, unless one is running
+        if (!(value & (1 << TWINT)) || twi.action != Twi::Action::None)
+        {
+            return;
+        }
+        twcr &= ~(1 << TWINT);
+
+        uint8_t status = mem(reg::twsr) & 0xF8;
+        if (value & (1 << TWSTO))
+        {
+            if (twi.target)
+            {
+                twi.target->stop();
+            }
+            twi.target = nullptr;
+            twi.mode = Twi::Mode::None;
+            twi.bus_owned = false;
+            twi.start_after_stop = value & (1 << TWSTA);
+            twiStatus(0xF8);
+            twiSchedule(Twi::Action::StopDone, 1);
+        }
+        else if (value & (1 << TWSTA))
+        {
+            twiSchedule(Twi::Action::Start, 1);
+        }
+        else if (status == 0x08 || status == 0x10)
+        {
+            twiSchedule(Twi::Action::Address, 9);
+        }
+        else if (twi.mode != Twi::Mode::None)
+        {
+            twiSchedule(Twi::Action::Data, 9);
+        }
+    }
+
+    void twiStepDone()
+    {
+        Twi::Action action = twi.action;
+        twi.action = Twi::Action::None;
+        twi.time = never;
+
+        switch (action)
+        {
+        case Twi::Action::StopDone:
+            mem(reg::twcr) &= ~(1 << TWSTO);
+            if (twi.start_after_stop)
+            {
+                twi.start_after_stop = false;
+                twiSchedule(Twi::Action::Start, 1);
+            }
+            return;
+
+        case Twi::Action::Start:
+            if (pins.driven_low[1] & sda_mask)
+            {
+                // The bus looks busy, so the hardware keeps waiting to send START
+                return;
+            }
+            twiStatus(twi.bus_owned ? 0x10 : 0x08);
+            twi.bus_owned = true;
+            twi.mode = Twi::Mode::None;
+            break;
+
+        case Twi::Action::Address:
+        {
+            uint8_t sla = mem(reg::twdr);
+            bool read = sla & 0x01;
+            twi.target = nullptr;
+            for (mm::sim::I2CTarget *device : twi.devices)
+            {
+                if (device->address() == (sla >> 1))
+                {
+                    twi.target = device;
+                    break;
+                }
+            }
+
+            if (twi.target)
+            {
+                twi.target->start(read);
+                twi.mode = read ? Twi::Mode::Receive : Twi::Mode::Transmit;
+                twiStatus(read ? 0x40 : 0x18);
+            }
+            else
+            {
+                twi.mode = Twi::Mode::None;
+                twiStatus(read ? 0x48 : 0x20);
+            }
+            break;
+        }
+
+        case Twi::Action::Data:
+            if (twi.mode == Twi::Mode::Transmit)
+            {
+                bool ack = twi.target->write(mem(reg::twdr));
+                twiStatus(ack ? 0x28 : 0x30);
+            }
+            else
+            {
+                bool ack = isSet(reg::twcr, TWEA);
+                mem(reg::twdr) = twi.target->read(ack);
+                twiStatus(ack ? 0x50 : 0x58);
+            }
+            break;
+
+        case Twi::Action::None:
+            return;
+        }
+
+        mem(reg::twcr) |= (1 << TWINT);
+    }
+
+    // ---- SPI ----
+
+    uint64_t spiByteCycles()
+    {
+        static const uint8_t dividers[4] = {4, 16, 64, 128};
+        uint8_t divider = dividers[mem(reg::spcr) & 0x03];
+        return 8ULL * (isSet(reg::spsr, SPI2X) ? divider / 2 : divider);
+    }
+
+    void spiDataAccess()
+    {
+        if (spi.flag_read)
+        {
+            spi.flag_read = false;
+            mem(reg::spsr) &= ~((1 << SPIF) | (1 << WCOL));
+        }
+    }
+
+    void spiWrite(uint8_t data)
+    {
+        spiDataAccess();
+        if (spi.busy)
+        {
+            mem(reg::spsr) |= (1 << WCOL);
+            return;
+        }
+        if (!isSet(reg::spcr, SPE))
+        {
+            return;
+        }
+        if (!isSet(reg::spcr, MSTR))
+        {
+            // Shifted out when an external master clocks the next byte
+            spi.slave_tx = data;
+            return;
+        }
+
+        spi.busy = true;
+        spi.tx = data;
+        spi.time = core.now + spiByteCycles();
+    }
+
+    void spiByteDone()
+    {
+        mm::sim::SPITarget *target = nullptr;
+        for (const Spi::Device &device : spi.devices)
+        {
+            if (device.selected)
+            {
+                target = device.target;
+                break;
+            }
+        }
+
+        spi.rx = target ? target->transfer(spi.tx) : 0xFF;
+        spi.busy = false;
+        spi.time = never;
+        mem(reg::spsr) |= (1 << SPIF);
+    }
+
+    void updateChipSelects()
+    {
+        for (Spi::Device &device : spi.devices)
+        {
+            bool selected = !(mem(device.port) & device.mask) && (mem(device.port - 1) & device.mask);
+            if (selected != device.selected)
+            {
+                device.selected = selected;
+                if (selected)
+                {
+                    device.target->select();
+                }
+                else
+                {
+                    device.target->deselect();
+                }
+            }
+        }
+    }
+
+    // ---- Timer0 / Timer2 ----
+
+    uint32_t timerPrescaler(const Timer &timer)
+    {
+        static const uint16_t timer0[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+        static const uint16_t timer2[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+        uint8_t cs = mem(timer.tccrb) & 0x07;
+        return timer.timer2 ? timer2[cs] : timer0[cs];
+    }
+
+    uint32_t timerTop(const Timer &timer)
+    {
+        // CTC (WGMx1) clears at OCRxA, normal mode wraps at 0xFF
+        return (mem(timer.tccra) & (1 << 1)) ? mem(timer.ocra) + 1U : 256U;
+    }
+
+    void timerRestart(Timer &timer)
+    {
+        timer.prescaler = timerPrescaler(timer);
+        if (!timer.prescaler)
+        {
+            timer.time = never;
+            return;
+        }
+
+        timer.epoch = core.now - (uint64_t)mem(timer.tcnt) * timer.prescaler;
+        timer.time = timer.epoch + (uint64_t)(mem(timer.ocra) + 1) * timer.prescaler;
+        while (timer.time <= core.now)
+        {
+            timer.time += (uint64_t)timerTop(timer) * timer.prescaler;
+        }
+    }
+
+    void timerCompare(Timer &timer)
+    {
+        mem(timer.tifr) |= (1 << 1);
+        if (mem(timer.tccra) & (1 << 1))
+        {
+            timer.epoch = timer.time;
+        }
+        timer.time += (uint64_t)timerTop(timer) * timer.prescaler;
+    }
+
+    uint8_t timerCount(const Timer &timer)
+    {
+        if (!timer.prescaler)
+        {
+            return mem(timer.tcnt);
+        }
+        return ((core.now - timer.epoch) / timer.prescaler) % timerTop(timer);
+    }
+
+    // ---- Events and interrupts ----
+
+    uint64_t nextEvent()
+    {
+        uint64_t next = twi.time;
+        next = usart.tx_busy && usart.tx_time < next ? usart.tx_time : next;
+        next = usart.rx_time < next ? usart.rx_time : next;
+        next = spi.busy && spi.time < next ? spi.time : next;
+        next = timer0.time < next ? timer0.time : next;
+        next = timer2.time < next ? timer2.time : next;
+        return next;
+    }
+
+    void runEvent(uint64_t time)
+    {
+        if (usart.tx_busy && usart.tx_time == time)
+        {
+            usartTransmitted();
+        }
+        else if (usart.rx_time == time)
+        {
+            usartReceived();
+        }
+        else if (twi.time == time)
+        {
+            twiStepDone();
+        }
+        else if (spi.busy && spi.time == time)
+        {
+            spiByteDone();
+        }
+        else if (timer0.time == time)
+        {
+            timerCompare(timer0);
+        }
+        else if (timer2.time == time)
+        {
+            timerCompare(timer2);
+        }
+    }
+
+    void (*const vectors[26])(void) = {
+        nullptr, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5, __vector_6,
+        __vector_7, __vector_8, __vector_9, __vector_10, __vector_11, __vector_12, __vector_13,
+        __vector_14, __vector_15, __vector_16, __vector_17, __vector_18, __vector_19, __vector_20,
+        __vector_21, __vector_22, __vector_23, __vector_24, __vector_25};
+
+    /**
+     * @brief Returns the highest priority pending interrupt and clears its flag if the hardware does.
+     */
+    uint8_t takeInterrupt()
+    {
+        if (isSet(reg::pcicr, PCIE0) && isSet(reg::pcifr, PCIF0))
+        {
+            mem(reg::pcifr) &= ~(1 << PCIF0);
+            return 3;
+        }
+        if (isSet(reg::timsk2, OCIE2A) && isSet(reg::tifr2, OCF2A))
+        {
+            mem(reg::tifr2) &= ~(1 << OCF2A);
+            return 7;
+        }
+        if (isSet(reg::timsk0, OCIE0A) && isSet(reg::tifr0, OCF0A))
+        {
+            mem(reg::tifr0) &= ~(1 << OCF0A);
+            return 14;
+        }
+        if (isSet(reg::spcr, SPIE) && isSet(reg::spsr, SPIF))
+        {
+            mem(reg::spsr) &= ~(1 << SPIF);
+            spi.flag_read = false;
+            return 17;
+        }
+        if (isSet(reg::ucsr0b, RXCIE0) && isSet(reg::ucsr0a, RXC0))
+        {
+            return 18;
+        }
+        if (isSet(reg::ucsr0b, UDRIE0) && isSet(reg::ucsr0a, UDRE0))
+        {
+            return 19;
+        }
+        if (isSet(reg::ucsr0b, TXCIE0) && isSet(reg::ucsr0a, TXC0))
+        {
+            mem(reg::ucsr0a) &= ~(1 << TXC0);
+            return 20;
+        }
+        if (isSet(reg::twcr, TWIE) && isSet(reg::twcr, TWINT))
+        {
+            return 24;
+        }
+        return 0;
+    }
+
+    void dispatchInterrupts()
+    {
+        while (!core.in_interrupt && isSet(reg::sreg, SREG_I))
+        {
+            uint8_t vector = takeInterrupt();
+            if (!vector)
+            {
+                return;
+            }
+            if (!vectors[vector])
+            {
+                // An AVR would jump to __bad_interrupt and reset
+                fprintf(stderr, "avrsim: interrupt %u enabled without an ISR\n", vector);
+                abort();
+            }
+
+            core.in_interrupt = true;
+            mem(reg::sreg) &= ~(1 << SREG_I);
+            core.now += mm::sim::interrupt_cycles;
+            vectors[vector]();
+            mem(reg::sreg) |= (1 << SREG_I);
+            core.in_interrupt = false;
+        }
+    }
+
+    uint8_t read(uint8_t address)
+    {
+        mm::sim::advance(mm::sim::access_cycles);
+
+        switch (address)
+        {
+        case reg::pinb:
+        case reg::pinc:
+        case reg::pind:
+            // Inputs read high (pull-ups on the GPIOs, idle level on the buses) unless driven low
+            return pinLevel(address);
+        case reg::udr0:
+            return usartRead();
+        case reg::spsr:
+            spi.flag_read = spi.flag_read || isSet(reg::spsr, SPIF);
+            return mem(reg::spsr);
+        case reg::spdr:
+            spiDataAccess();
+            return spi.rx;
+        case reg::tcnt0:
+            return timerCount(timer0);
+        case reg::tcnt2:
+            return timerCount(timer2);
+        default:
+            return mem(address);
+        }
+    }
+
+    void write(uint8_t address, uint8_t value)
+    {
+        mm::sim::advance(mm::sim::access_cycles);
+
+        switch (address)
+        {
+        case reg::pinb:
+        case reg::pinc:
+        case reg::pind:
+            // Writing ones to PINx toggles PORTx
+            mem(address + 2) ^= value;
+            updateChipSelects();
+            updatePinChange();
+            break;
+        case reg::ddrc:
+            ddrcChanged(mem(address), value);
+            mem(address) = value;
+            updateChipSelects();
+            break;
+        case reg::ddrb:
+        case reg::portb:
+        case reg::portc:
+        case reg::ddrd:
+        case reg::portd:
+            mem(address) = value;
+            updateChipSelects();
+            updatePinChange();
+            break;
+        case reg::ucsr0a:
+        {
+            uint8_t writable = (1 << U2X0) | (1 << MPCM0);
+            mem(address) = (mem(address) & ~writable) | (value & writable);
+            if (value & (1 << TXC0))
+            {
+                mem(address) &= ~(1 << TXC0);
+            }
+            break;
+        }
+        case reg::udr0:
+            usartWrite(value);
+            break;
+        case reg::twcr:
+            twiControl(value);
+            break;
+        case reg::twsr:
+            mem(address) = (mem(address) & 0xF8) | (value & 0x03);
+            break;
+        case reg::twdr:
+            if (isSet(reg::twcr, TWINT))
+            {
+                mem(address) = value;
+            }
+            else
+            {
+                mem(reg::twcr) |= (1 << TWWC);
+            }
+            break;
+        case reg::spsr:
+            mem(address) = (mem(address) & ~(1 << SPI2X)) | (value & (1 << SPI2X));
+            break;
+        case reg::spdr:
+            spiWrite(value);
+            break;
+        case reg::tccr0a:
+        case reg::tccr0b:
+        case reg::tcnt0:
+        case reg::ocr0a:
+            mem(address) = value;
+            timerRestart(timer0);
+            break;
+        case reg::tccr2a:
+        case reg::tccr2b:
+        case reg::tcnt2:
+        case reg::ocr2a:
+            mem(address) = value;
+            timerRestart(timer2);
+            break;
+        case reg::tifr0:
+        case reg::tifr1:
+        case reg::tifr2:
+        case reg::pcifr:
+            mem(address) &= ~value;
+            break;
+        default:
+            mem(address) = value;
+            break;
+        }
+
+        // E.g. sei() or enabling an interrupt whose flag is already set
+        dispatchInterrupts();
+    }
+
+    /**
+     * @brief Puts the simulator in its reset state before main() runs.
+     */
+    struct Startup
+    {
+        Startup()
+        {
+            mm::sim::reset();
+        }
+    };
+
+    Startup startup;
+}
+
+mm::sim::Register::operator uint8_t() const
+{
+    return read(address());
+}
+
+mm::sim::Register &mm::sim::Register::operator=(uint8_t value)
+{
+    write(address(), value);
+    return *this;
+}
+
+uint8_t mm::sim::Register::address() const
+{
+    return (uint8_t)(this - io);
+}
+
+void mm::sim::reset()
+{
+    core.now = 0;
+    core.in_interrupt = false;
+    memset(core.mem, 0, sizeof(core.mem));
+    mem(reg::ucsr0a) = (1 << UDRE0);
+    mem(reg::ucsr0c) = (1 << UCSZ01) | (1 << UCSZ00);
+    mem(reg::twsr) = 0xF8;
+    mem(reg::twdr) = 0xFF;
+
+    pins = Pins();
+    pins.pinb = 0xFF;
+    usart = Usart();
+    usart.rx_time = never;
+    twi = Twi();
+    twi.time = never;
+    spi = Spi();
+    spi.time = never;
+    spi.slave_tx = 0xFF;
+    timer0.prescaler = timer2.prescaler = 0;
+    timer0.time = timer2.time = never;
+}
+
+uint64_t mm::sim::cycles()
+{
+    return core.now;
+}
+
+double mm::sim::microseconds(uint64_t cycles)
+{
+    return cycles * 1e6 / F_CPU;
+}
+
+void mm::sim::advance(uint64_t cycles)
+{
+    uint64_t target = core.now + cycles;
+
+    for (;;)
+    {
+        uint64_t next = nextEvent();
+        if (next > target)
+        {
+            break;
+        }
+        if (next > core.now)
+        {
+            core.now = next;
+        }
+        runEvent(next);
+        dispatchInterrupts();
+    }
+
+    if (core.now < target)
+    {
+        core.now = target;
+    }
+    dispatchInterrupts();
+}
+
+void mm::sim::idle()
+{
+    advance(2 * access_cycles);
+}
+
+void mm::sim::sleep()
+{
+    uint64_t next = nextEvent();
+    if (!isSet(reg::smcr, SE) || next == never)
+    {
+        advance(1);
+        return;
+    }
+    advance(next > core.now ? next - core.now : 0);
+}
+
+void mm::sim::attachI2C(I2CTarget &target)
+{
+    twi.devices.push_back(&target);
+}
+
+void mm::sim::attachSPI(SPITarget &target, Register &cs_port, uint8_t cs_pin)
+{
+    spi.devices.push_back(Spi::Device{&target, cs_port.address(), (uint8_t)(1 << cs_pin), false});
+    updateChipSelects();
+}
+
+void mm::sim::uartInject(const uint8_t *data, size_t len)
+{
+    if (usart.rx_line.empty() && len)
+    {
+        usart.rx_time = core.now + usartFrameCycles();
+    }
+    usart.rx_line.insert(usart.rx_line.end(), data, data + len);
+}
+
+std::vector<uint8_t> &mm::sim::uartOutput()
+{
+    return usart.output;
+}
+
+void mm::sim::drivePin(Register &pin_register, uint8_t pin, bool low)
+{
+    uint8_t &driven = pins.driven_low[(pin_register.address() - reg::pinb) / 3];
+    driven = low ? driven | (1 << pin) : driven & ~(1 << pin);
+    updatePinChange();
+    dispatchInterrupts();
+}
+
+void mm::sim::holdSDA(uint8_t clocks)
+{
+    pins.sda_clocks = clocks;
+    if (clocks)
+    {
+        pins.driven_low[1] |= sda_mask;
+    }
+    else
+    {
+        pins.driven_low[1] &= ~sda_mask;
+    }
+}
+
+namespace
+{
+    constexpr uint64_t external_bit_cycles = F_CPU / 100000; ///< SCL period of the external I2C master.
+    constexpr uint16_t stretch_limit = 1000;                 ///< Bit times a slave may hold SCL low.
+
+    /**
+     * @brief Checks whether the TWI answers an address as a slave.
+     */
+    bool twiSlaveAddressed(uint8_t address)
+    {
+        if (!isSet(reg::twcr, TWEN) || !isSet(reg::twcr, TWEA) || twi.bus_owned)
+        {
+            return false;
+        }
+        if (address == 0)
+        {
+            return isSet(reg::twar, TWGCE);
+        }
+        uint8_t ignored = mem(reg::twamr) >> 1;
+        return ((address ^ (mem(reg::twar) >> 1)) & ~ignored & 0x7F) == 0;
+    }
+
+    /**
+     * @brief Transfers one byte on the bus, reports the status and waits for the slave.
+     *
+     * The slave holds SCL low until its interrupt clears TWINT.
+     *
+     * @return False if the slave never released SCL.
+     */
+    bool twiSlaveStep(uint8_t status)
+    {
+        mm::sim::advance(9 * external_bit_cycles);
+        twiStatus(status);
+        mem(reg::twcr) |= (1 << TWINT);
+        dispatchInterrupts();
+        for (uint16_t i = 0; isSet(reg::twcr, TWINT); i++)
+        {
+            if (i == stretch_limit)
+            {
+                return false;
+            }
+            mm::sim::advance(external_bit_cycles);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Ends a transfer of the external master; the bus is free again.
+     */
+    void twiSlaveIdle()
+    {
+        mm::sim::advance(external_bit_cycles);
+        twiStatus(0xF8);
+    }
+}
+
+bool mm::sim::i2cMasterWrite(uint8_t address, const uint8_t *data, uint8_t len)
+{
+    if (!twiSlaveAddressed(address))
+    {
+        mm::sim::advance(9 * external_bit_cycles);
+        twiSlaveIdle();
+        return false;
+    }
+
+    bool general_call = address == 0;
+    bool acked = twiSlaveStep(general_call ? 0x70 : 0x60);
+    for (uint8_t i = 0; acked && i < len; i++)
+    {
+        // TWEA at the time the previous byte was released decides the acknowledge
+        bool ack = isSet(reg::twcr, TWEA);
+        mem(reg::twdr) = data[i];
+        uint8_t status = general_call ? (ack ? 0x90 : 0x98) : (ack ? 0x80 : 0x88);
+        acked = twiSlaveStep(status) && ack;
+    }
+    if (acked)
+    {
+        twiSlaveStep(0xA0);
+    }
+    twiSlaveIdle();
+    return acked;
+}
+
+bool mm::sim::i2cMasterRead(uint8_t address, uint8_t *data, uint8_t len)
+{
+    if (address == 0 || !twiSlaveAddressed(address) || len == 0)
+    {
+        mm::sim::advance(9 * external_bit_cycles);
+        twiSlaveIdle();
+        return false;
+    }
+
+    bool released = twiSlaveStep(0xA8);
+    for (uint8_t i = 0; released && i < len; i++)
+    {
+        data[i] = mem(reg::twdr);
+        // The master acknowledges every byte but the last
+        released = twiSlaveStep(i + 1 < len ? 0xB8 : 0xC0);
+    }
+    twiSlaveIdle();
+    return released;
+}
+
+uint8_t mm::sim::spiMasterTransfer(uint8_t data)
+{
+    // 8 bits at an SCK of 1 MHz
+    mm::sim::advance(8 * (F_CPU / 1000000UL));
+    if (!isSet(reg::spcr, SPE) || isSet(reg::spcr, MSTR) || (pinLevel(reg::pinb) & (1 << PB2)))
+    {
+        return 0xFF;
+    }
+
+    // Without a new SPDR write the slave shifts out what it has just received
+    uint8_t out = spi.slave_tx;
+    spi.slave_tx = data;
+    spi.rx = data;
+    mem(reg::spsr) |= (1 << SPIF);
+    dispatchInterrupts();
+    return out;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file AvrSim.h
+ * @brief Host simulation of the ATmega328P registers and peripherals.
+ *
+ * This library replaces avr-libc when the drivers are built as a native program. Its
+ * `<avr/io.h>` maps every register name to an `mm::sim::Register` object; reading or
+ * writing one goes through the functions below, which model the USART, the TWI and SPI
+ * masters, Timer0/Timer2 in CTC mode and the GPIO ports with their timing, and run the
+ * driver's `ISR()` functions when an enabled interrupt becomes pending. The TWI and SPI
+ * slave modes are driven by an external master through `i2cMasterWrite()`,
+ * `i2cMasterRead()` and `spiMasterTransfer()`.
+ *
+ * Simulated time is counted in CPU cycles. Only register accesses, delays, busy-wait
+ * hooks, sleeping and interrupts advance it; the instructions between them are free.
+ * Results therefore show the cost of the peripherals and bus protocols, not of the CPU
+ * code, which needs a cycle-accurate AVR simulator.
+ *
+ * @note Not for the target: the header only exists in the native build.
+ */
+
+#ifndef AVR_SIM_H
+#define AVR_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace mm
+{
+    namespace sim
+    {
+        /**
+         * @class Register
+         * @brief One 8-bit register in the simulated data space.
+         *
+         * The registers form an array indexed by data space address, so pointer arithmetic
+         * between them works as on the AVR (e.g. DDRx sits directly below PORTx).
+         */
+        class Register
+        {
+        public:
+            Register() = default;
+            Register(const Register &) = delete;
+
+            /**
+             * @brief Reads the register.
+             */
+            operator uint8_t() const;
+
+            /**
+             * @brief Writes the register.
+             */
+            Register &operator=(uint8_t value);
+
+            /**
+             * @brief Copies the value of another register.
+             */
+            Register &operator=(const Register &other)
+            {
+                return *this = (uint8_t)other;
+            }
+
+            Register &operator|=(int value)
+            {
+                return *this = (uint8_t)(*this | value);
+            }
+
+            Register &operator&=(int value)
+            {
+                return *this = (uint8_t)(*this & value);
+            }
+
+            Register &operator^=(int value)
+            {
+                return *this = (uint8_t)(*this ^ value);
+            }
+
+            /**
+             * @brief Returns the data space address of the register.
+             */
+            uint8_t address() const;
+        };
+
+        extern Register io[256]; ///< Data space addresses 0x00..0xFF.
+
+        /**
+         * @brief CPU cycles charged for each register access.
+         */
+        constexpr uint8_t access_cycles = 4;
+
+        /**
+         * @brief CPU cycles charged for entering and leaving an interrupt.
+         */
+        constexpr uint8_t interrupt_cycles = 10;
+
+        /**
+         * @class I2CTarget
+         * @brief A device on the simulated I2C bus.
+         */
+        class I2CTarget
+        {
+        public:
+            virtual ~I2CTarget() = default;
+
+            /**
+             * @brief Returns the 7-bit address of the device.
+             */
+            virtual uint8_t address() const = 0;
+
+            /**
+             * @brief Called after the device acknowledged its address.
+             *
+             * @param read True for a read transfer.
+             */
+            virtual void start(bool read) = 0;
+
+            /**
+             * @brief Receives a byte from the master.
+             *
+             * @return True to acknowledge the byte.
+             */
+            virtual bool write(uint8_t data) = 0;
+
+            /**
+             * @brief Sends a byte to the master.
+             *
+             * @param ack Whether the master will acknowledge the byte.
+             */
+            virtual uint8_t read(bool ack) = 0;
+
+            /**
+             * @brief Called on a STOP condition.
+             */
+            virtual void stop() = 0;
+        };
+
+        /**
+         * @class SPITarget
+         * @brief A device on the simulated SPI bus.
+         */
+        class SPITarget
+        {
+        public:
+            virtual ~SPITarget() = default;
+
+            /**
+             * @brief Called when the chip select goes low.
+             */
+            virtual void select() = 0;
+
+            /**
+             * @brief Exchanges one byte.
+             *
+             * @param data The byte sent by the master.
+             * @return The byte sent back.
+             */
+            virtual uint8_t transfer(uint8_t data) = 0;
+
+            /**
+             * @brief Called when the chip select goes high.
+             */
+            virtual void deselect() = 0;
+        };
+
+        /**
+         * @brief Resets time, registers and peripherals and detaches all devices.
+         */
+        void reset();
+
+        /**
+         * @brief Returns the CPU cycles simulated so far.
+         */
+        uint64_t cycles();
+
+        /**
+         * @brief Converts cycles to microseconds at `F_CPU`.
+         */
+        double microseconds(uint64_t cycles);
+
+        /**
+         * @brief Advances time, running peripheral events and interrupts on the way.
+         *
+         * @param cycles The number of CPU cycles to let pass.
+         */
+        void advance(uint64_t cycles);
+
+        /**
+         * @brief One iteration of a busy-wait loop on memory, see `mm::busyWait()`.
+         */
+        void idle();
+
+        /**
+         * @brief Executes `sleep_cpu()`: jumps to the next peripheral event if sleep is enabled.
+         */
+        void sleep();
+
+        /**
+         * @brief Attaches a device to the I2C bus.
+         */
+        void attachI2C(I2CTarget &target);
+
+        /**
+         * @brief Attaches a device to the SPI bus.
+         *
+         * @param target The device.
+         * @param cs_port The PORT register of its chip select, e.g. `PORTB`.
+         * @param cs_pin The pin number of the chip select.
+         */
+        void attachSPI(SPITarget &target, Register &cs_port, uint8_t cs_pin);
+
+        /**
+         * @brief Pulls a GPIO pin low from outside the chip, or releases it.
+         *
+         * An input pin reads low while it is pulled low. Changes on port B raise the pin
+         * change interrupt PCINT0 for the pins enabled in PCMSK0.
+         *
+         * @param pin_register The PIN register of the port, e.g. `PINB`.
+         * @param pin The pin number.
+         * @param low True to pull the pin low, false to release it.
+         */
+        void drivePin(Register &pin_register, uint8_t pin, bool low);
+
+        /**
+         * @brief Lets a slave hold SDA (PC4) low until it has seen a number of SCL pulses.
+         *
+         * Models a slave that was interrupted in the middle of a read and still drives a 0
+         * bit. Only pulses generated by hand on SCL (PC5) count. While SDA is low the TWI
+         * master cannot send START.
+         *
+         * @param clocks Pulses until SDA is released, 0xFF to hold it for good, 0 to release it now.
+         */
+        void holdSDA(uint8_t clocks);
+
+        /**
+         * @brief Writes bytes to the TWI in slave mode, acting as another master at 100 kHz.
+         *
+         * Each step sets the slave receiver status code and waits for the TWI interrupt,
+         * which must be enabled together with global interrupts.
+         *
+         * @param address The 7-bit address, 0 for a general call.
+         * @param data The bytes to write.
+         * @param len Number of bytes.
+         * @return True if the address and every byte were acknowledged.
+         */
+        bool i2cMasterWrite(uint8_t address, const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Reads bytes from the TWI in slave mode, acting as another master at 100 kHz.
+         *
+         * The master acknowledges all bytes but the last one.
+         *
+         * @param address The 7-bit address.
+         * @param data Buffer for the bytes.
+         * @param len Number of bytes to read.
+         * @return True if the address was acknowledged and the slave answered every byte.
+         */
+        bool i2cMasterRead(uint8_t address, uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Exchanges one byte with the SPI in slave mode, acting as an external master.
+         *
+         * The byte takes 8 µs (1 MHz SCK). SS (PB2) must have been pulled low with
+         * `drivePin()`; otherwise the slave ignores the clock and 0xFF is returned.
+         *
+         * @param data The byte sent on MOSI.
+         * @return The byte the slave sent on MISO.
+         */
+        uint8_t spiMasterTransfer(uint8_t data);
+
+        /**
+         * @brief Queues bytes for the USART0 receiver, arriving back-to-back at the configured baud rate.
+         */
+        void uartInject(const uint8_t *data, size_t len);
+
+        /**
+         * @brief Returns all bytes sent by USART0 so far.
+         */
+        std::vector<uint8_t> &uartOutput();
+    }
+}
+
+#endif // AVR_SIM_H
@@ -0,0 +1,225 @@
+#include "BME280Sim.h"
+#include <avr/io.h>
+#include <string.h>
+
+namespace
+{
+    // Calibration of the example in the BME280 datasheet, registers 0x88..0xA1 and 0xE1..0xE7
+    const uint8_t calibration_tp[26] = {
+        0x70, 0x6B, // dig_T1 = 27504
+        0x43, 0x67, // dig_T2 = 26435
+        0x18, 0xFC, // dig_T3 = -1000
+        0x7D, 0x8E, // dig_P1 = 36477
+        0x43, 0xD6, // dig_P2 = -10685
+        0xD0, 0x0B, // dig_P3 = 3024
+        0x27, 0x0B, // dig_P4 = 2855
+        0x8C, 0x00, // dig_P5 = 140
+        0xF9, 0xFF, // dig_P6 = -7
+        0x8C, 0x3C, // dig_P7 = 15500
+        0xF8, 0xC6, // dig_P8 = -14600
+        0x70, 0x17, // dig_P9 = 6000
+        0x00,       // reserved
+        0x4B,       // dig_H1 = 75
+    };
+    const uint8_t calibration_h[7] = {
+        0x6A, 0x01, // dig_H2 = 362
+        0x00,       // dig_H3 = 0
+        0x13, 0x29, // dig_H4 = 313, dig_H5 low nibble
+        0x03,       // dig_H5 = 50
+        0x1E,       // dig_H6 = 30
+    };
+
+    constexpr uint8_t reg_id = 0xD0, reg_reset = 0xE0, reg_ctrl_hum = 0xF2, reg_status = 0xF3;
+    constexpr uint8_t reg_ctrl_meas = 0xF4, reg_config = 0xF5, reg_data = 0xF7;
+
+    /**
+     * @brief Returns the oversampling factor of a 3-bit osrs field, 0 when skipped.
+     */
+    uint8_t oversampling(uint8_t osrs)
+    {
+        return osrs == 0 ? 0 : osrs >= 5 ? 16 : 1 << (osrs - 1);
+    }
+}
+
+mm::sim::BME280Sim::BME280Sim(uint8_t address)
+    : i2c_address(address), pointer(0), have_address(false), reading(false), index(0),
+      adc_t(519888), adc_p(415148), adc_h(30000), measure_end(0), measurements(0)
+{
+    resetRegisters();
+}
+
+void mm::sim::BME280Sim::resetRegisters()
+{
+    memset(registers, 0, sizeof(registers));
+    memcpy(&registers[0x88], calibration_tp, sizeof(calibration_tp));
+    memcpy(&registers[0xE1], calibration_h, sizeof(calibration_h));
+    registers[reg_id] = 0x60;
+
+    // Data registers hold 0x80000 / 0x8000 until the first measurement
+    registers[0xF7] = 0x80;
+    registers[0xFA] = 0x80;
+    registers[0xFD] = 0x80;
+}
+
+void mm::sim::BME280Sim::setRaw(uint32_t adc_t, uint32_t adc_p, uint16_t adc_h)
+{
+    this->adc_t = adc_t;
+    this->adc_p = adc_p;
+    this->adc_h = adc_h;
+}
+
+void mm::sim::BME280Sim::setCalibration(uint8_t reg, uint8_t value)
+{
+    registers[reg] = value;
+}
+
+uint32_t mm::sim::BME280Sim::measurementTime(uint8_t ctrl_hum, uint8_t ctrl_meas)
+{
+    uint8_t t = oversampling((ctrl_meas >> 5) & 0x07);
+    uint8_t p = oversampling((ctrl_meas >> 2) & 0x07);
+    uint8_t h = oversampling(ctrl_hum & 0x07);
+
+    // Datasheet section 9.1: 1.25 ms + 2.3 ms per sample, 0.575 ms setup for P and H
+    return 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+}
+
+void mm::sim::BME280Sim::latch()
+{
+    uint8_t ctrl_meas = registers[reg_ctrl_meas];
+    uint8_t ctrl_hum = registers[reg_ctrl_hum];
+
+    // Skipped measurements keep their reset value
+    uint32_t p = (ctrl_meas >> 2) & 0x07 ? adc_p : 0x80000;
+    uint32_t t = (ctrl_meas >> 5) & 0x07 ? adc_t : 0x80000;
+    uint16_t h = ctrl_hum & 0x07 ? adc_h : 0x8000;
+
+    registers[0xF7] = p >> 12;
+    registers[0xF8] = p >> 4;
+    registers[0xF9] = (p << 4) & 0xF0;
+    registers[0xFA] = t >> 12;
+    registers[0xFB] = t >> 4;
+    registers[0xFC] = (t << 4) & 0xF0;
+    registers[0xFD] = h >> 8;
+    registers[0xFE] = h;
+    measurements++;
+}
+
+void mm::sim::BME280Sim::update()
+{
+    uint8_t mode = registers[reg_ctrl_meas] & 0x03;
+
+    if (mode == 0x03)
+    {
+        // Normal mode: a measurement is always available
+        latch();
+    }
+    else if ((registers[reg_status] & 0x08) && cycles() >= measure_end)
+    {
+        // Forced measurement done, back to sleep
+        latch();
+        registers[reg_status] &= ~0x08;
+        registers[reg_ctrl_meas] &= ~0x03;
+    }
+}
+
+uint8_t mm::sim::BME280Sim::readRegister(uint8_t reg)
+{
+    if (reg == reg_status || reg == reg_ctrl_meas || reg == reg_data)
+    {
+        update();
+    }
+    return registers[reg];
+}
+
+void mm::sim::BME280Sim::writeRegister(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case reg_reset:
+        if (value == 0xB6)
+        {
+            resetRegisters();
+        }
+        break;
+    case reg_ctrl_hum:
+        registers[reg] = value & 0x07;
+        break;
+    case reg_config:
+        registers[reg] = value & 0xFD;
+        break;
+    case reg_ctrl_meas:
+        registers[reg] = value;
+        if ((value & 0x03) == 0x01 || (value & 0x03) == 0x02)
+        {
+            registers[reg_status] |= 0x08;
+            measure_end = cycles() + (uint64_t)measurementTime(registers[reg_ctrl_hum], value) * (F_CPU / 1000000UL);
+        }
+        break;
+    default:
+        // Everything else is read-only
+        break;
+    }
+}
+
+uint8_t mm::sim::BME280Sim::address() const
+{
+    return i2c_address;
+}
+
+void mm::sim::BME280Sim::start(bool)
+{
+    have_address = false;
+}
+
+bool mm::sim::BME280Sim::write(uint8_t data)
+{
+    // Register address, then address/data pairs
+    if (!have_address)
+    {
+        pointer = data;
+    }
+    else
+    {
+        writeRegister(pointer, data);
+    }
+    have_address = !have_address;
+    return true;
+}
+
+uint8_t mm::sim::BME280Sim::read(bool)
+{
+    return readRegister(pointer++);
+}
+
+void mm::sim::BME280Sim::stop() {}
+
+void mm::sim::BME280Sim::select()
+{
+    index = 0;
+}
+
+uint8_t mm::sim::BME280Sim::transfer(uint8_t data)
+{
+    // Bit 7 of a control byte selects read (1) or write (0); bit 7 of the register is implied
+    if (index++ == 0)
+    {
+        reading = data & 0x80;
+        pointer = data | 0x80;
+        return 0xFF;
+    }
+    if (reading)
+    {
+        return readRegister(pointer++);
+    }
+    if (index % 2 == 0)
+    {
+        writeRegister(pointer, data);
+    }
+    else
+    {
+        pointer = data | 0x80;
+    }
+    return 0xFF;
+}
+
+void mm::sim::BME280Sim::deselect() {}
@@ -0,0 +1,96 @@
+/**
+ * @file BME280Sim.h
+ * @brief Simulated Bosch BME280 for the host build.
+ *
+ * The model answers on the simulated I2C bus (address 0x76 or 0x77) and on the SPI bus
+ * with the register protocol of the real sensor: register map with auto-increment reads,
+ * address/data pairs for writes, chip ID, soft reset, calibration data from the example
+ * in the datasheet, and sleep, forced and normal mode with the datasheet's maximum
+ * measurement time.
+ */
+
+#ifndef BME280_SIM_H
+#define BME280_SIM_H
+
+#include <stdint.h>
+#include "AvrSim.h"
+
+namespace mm
+{
+    namespace sim
+    {
+        /**
+         * @class BME280Sim
+         * @brief A BME280 returning configurable raw ADC values.
+         */
+        class BME280Sim : public I2CTarget, public SPITarget
+        {
+        private:
+            uint8_t i2c_address;   ///< Address on the I2C bus.
+            uint8_t registers[256]; ///< Register map.
+            uint8_t pointer;       ///< Register pointer for the next access.
+            bool have_address;     ///< An I2C write has set the pointer, the next byte is data.
+            bool reading;          ///< The current SPI frame is a read.
+            uint8_t index;         ///< Position in the current SPI frame.
+            uint32_t adc_t;        ///< Raw temperature of the next measurement.
+            uint32_t adc_p;        ///< Raw pressure of the next measurement.
+            uint16_t adc_h;        ///< Raw humidity of the next measurement.
+            uint64_t measure_end;  ///< End of the running forced measurement, in CPU cycles.
+            uint32_t measurements; ///< Completed measurements.
+
+            void resetRegisters();
+            void latch();
+            void update();
+            uint8_t readRegister(uint8_t reg);
+            void writeRegister(uint8_t reg, uint8_t value);
+
+        public:
+            /**
+             * @brief Constructs a sensor with the datasheet example readings (25.08 C, 1006.5 hPa).
+             *
+             * @param address The I2C address, 0x76 or 0x77.
+             */
+            explicit BME280Sim(uint8_t address = 0x76);
+
+            /**
+             * @brief Sets the raw ADC values reported by the following measurements.
+             */
+            void setRaw(uint32_t adc_t, uint32_t adc_p, uint16_t adc_h);
+
+            /**
+             * @brief Overwrites one calibration register, e.g. to model a different part.
+             *
+             * A soft reset restores the datasheet example.
+             */
+            void setCalibration(uint8_t reg, uint8_t value);
+
+            /**
+             * @brief Returns the number of measurements the sensor has completed.
+             */
+            uint32_t measurementCount() const
+            {
+                return measurements;
+            }
+
+            /**
+             * @brief Returns the maximum measurement time in microseconds for a configuration.
+             *
+             * @param ctrl_hum Value of register 0xF2.
+             * @param ctrl_meas Value of register 0xF4.
+             */
+            static uint32_t measurementTime(uint8_t ctrl_hum, uint8_t ctrl_meas);
+
+            uint8_t address() const override;
+            void start(bool read) override;
+            bool write(uint8_t data) override;
+            uint8_t read(bool ack) override;
+            void stop() override;
+
+            void select() override;
+            uint8_t transfer(uint8_t data) override;
+            void deselect() override;
+        };
+    }
+}
+
+#endif // BME280_SIM_H
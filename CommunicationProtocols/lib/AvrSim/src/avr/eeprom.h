@@ -0,0 +1,48 @@
+/**
+ * @file eeprom.h
+ * @brief Host replacement for avr-libc's `<avr/eeprom.h>`.
+ *
+ * `EEMEM` variables are ordinary RAM variables, so the EEPROM keeps its contents for the
+ * lifetime of the process.
+ */
+
+#ifndef MM_SIM_AVR_EEPROM_H
+#define MM_SIM_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define EEMEM
+
+inline uint8_t eeprom_read_byte(const uint8_t *address)
+{
+    return *address;
+}
+
+inline void eeprom_read_block(void *dst, const void *src, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+inline void eeprom_write_byte(uint8_t *address, uint8_t value)
+{
+    *address = value;
+}
+
+inline void eeprom_update_byte(uint8_t *address, uint8_t value)
+{
+    *address = value;
+}
+
+inline void eeprom_write_block(const void *src, void *dst, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+inline void eeprom_update_block(const void *src, void *dst, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+#endif // MM_SIM_AVR_EEPROM_H
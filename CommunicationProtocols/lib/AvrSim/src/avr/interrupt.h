@@ -0,0 +1,21 @@
+/**
+ * @file interrupt.h
+ * @brief Host replacement for avr-libc's `<avr/interrupt.h>`.
+ *
+ * `ISR(vector)` defines a C function named after the vector number, which the simulator
+ * calls when the interrupt is enabled and pending.
+ */
+
+#ifndef MM_SIM_AVR_INTERRUPT_H
+#define MM_SIM_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)             \
+    extern "C" void vector(void);    \
+    extern "C" void vector(void)
+
+#define sei() (SREG |= (1 << SREG_I))
+#define cli() (SREG &= (uint8_t)~(1 << SREG_I))
+
+#endif // MM_SIM_AVR_INTERRUPT_H
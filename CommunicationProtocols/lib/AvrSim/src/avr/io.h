@@ -0,0 +1,208 @@
+/**
+ * @file io.h
+ * @brief Host replacement for avr-libc's `<avr/io.h>`, modelled on the ATmega328P.
+ *
+ * Register names expand to `mm::sim::Register` objects at their data space addresses, so
+ * driver code such as `SPDR = data` or `while (!(SPSR & (1 << SPIF)))` drives the
+ * simulated peripherals unchanged.
+ */
+
+#ifndef MM_SIM_AVR_IO_H
+#define MM_SIM_AVR_IO_H
+
+#include <stdint.h>
+#include "../AvrSim.h"
+
+#define MM_HOST_SIMULATION 1
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_MEM8(addr) (mm::sim::io[(addr)])
+
+// GPIO
+#define PINB _SFR_MEM8(0x23)
+#define DDRB _SFR_MEM8(0x24)
+#define PORTB _SFR_MEM8(0x25)
+#define PINC _SFR_MEM8(0x26)
+#define DDRC _SFR_MEM8(0x27)
+#define PORTC _SFR_MEM8(0x28)
+#define PIND _SFR_MEM8(0x29)
+#define DDRD _SFR_MEM8(0x2A)
+#define PORTD _SFR_MEM8(0x2B)
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+// Interrupt flags and masks
+#define TIFR0 _SFR_MEM8(0x35)
+#define TIFR1 _SFR_MEM8(0x36)
+#define TIFR2 _SFR_MEM8(0x37)
+#define PCIFR _SFR_MEM8(0x3B)
+#define PCICR _SFR_MEM8(0x68)
+#define PCMSK0 _SFR_MEM8(0x6B)
+#define PCMSK1 _SFR_MEM8(0x6C)
+#define PCMSK2 _SFR_MEM8(0x6D)
+#define TIMSK0 _SFR_MEM8(0x6E)
+#define TIMSK1 _SFR_MEM8(0x6F)
+#define TIMSK2 _SFR_MEM8(0x70)
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+#define OCF0A 1
+#define OCF2A 1
+#define OCIE0A 1
+#define OCIE1A 1
+#define OCIE2A 1
+#define TOIE1 0
+
+// Timer0
+#define TCCR0A _SFR_MEM8(0x44)
+#define TCCR0B _SFR_MEM8(0x45)
+#define TCNT0 _SFR_MEM8(0x46)
+#define OCR0A _SFR_MEM8(0x47)
+#define WGM00 0
+#define WGM01 1
+#define CS00 0
+#define CS01 1
+#define CS02 2
+
+// Timer1 (no simulation, registers only)
+#define TCCR1A _SFR_MEM8(0x80)
+#define TCCR1B _SFR_MEM8(0x81)
+#define CS10 0
+#define CS11 1
+#define CS12 2
+
+// Timer2
+#define TCCR2A _SFR_MEM8(0xB0)
+#define TCCR2B _SFR_MEM8(0xB1)
+#define TCNT2 _SFR_MEM8(0xB2)
+#define OCR2A _SFR_MEM8(0xB3)
+#define WGM20 0
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+
+// SPI
+#define SPCR _SFR_MEM8(0x4C)
+#define SPSR _SFR_MEM8(0x4D)
+#define SPDR _SFR_MEM8(0x4E)
+#define SPR0 0
+#define SPR1 1
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define WCOL 6
+#define SPIF 7
+
+// Sleep mode and status register
+#define SMCR _SFR_MEM8(0x53)
+#define MCUSR _SFR_MEM8(0x54)
+#define SREG _SFR_MEM8(0x5F)
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define SREG_I 7
+
+// TWI
+#define TWBR _SFR_MEM8(0xB8)
+#define TWSR _SFR_MEM8(0xB9)
+#define TWAR _SFR_MEM8(0xBA)
+#define TWDR _SFR_MEM8(0xBB)
+#define TWCR _SFR_MEM8(0xBC)
+#define TWAMR _SFR_MEM8(0xBD)
+#define TWPS0 0
+#define TWPS1 1
+#define TWGCE 0
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+// USART0
+#define UCSR0A _SFR_MEM8(0xC0)
+#define UCSR0B _SFR_MEM8(0xC1)
+#define UCSR0C _SFR_MEM8(0xC2)
+#define UBRR0L _SFR_MEM8(0xC4)
+#define UBRR0H _SFR_MEM8(0xC5)
+#define UDR0 _SFR_MEM8(0xC6)
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXB80 0
+#define RXB80 1
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCPOL0 0
+#define UCSZ00 1
+#define UCSZ01 2
+#define USBS0 3
+#define UPM00 4
+#define UPM01 5
+
+// Interrupt vectors
+#define PCINT0_vect __vector_3
+#define TIMER2_COMPA_vect __vector_7
+#define TIMER0_COMPA_vect __vector_14
+#define SPI_STC_vect __vector_17
+#define USART_RX_vect __vector_18
+#define USART_UDRE_vect __vector_19
+#define USART_TX_vect __vector_20
+#define TWI_vect __vector_24
+
+#define E2END 0x3FF
+#define RAMEND 0x8FF
+
+#endif // MM_SIM_AVR_IO_H
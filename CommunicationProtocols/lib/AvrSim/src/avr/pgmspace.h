@@ -0,0 +1,18 @@
+/**
+ * @file pgmspace.h
+ * @brief Host replacement for avr-libc's `<avr/pgmspace.h>`; flash data lives in RAM.
+ */
+
+#ifndef MM_SIM_AVR_PGMSPACE_H
+#define MM_SIM_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+
+#endif // MM_SIM_AVR_PGMSPACE_H
@@ -0,0 +1,28 @@
+/**
+ * @file sleep.h
+ * @brief Host replacement for avr-libc's `<avr/sleep.h>`.
+ */
+
+#ifndef MM_SIM_AVR_SLEEP_H
+#define MM_SIM_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE ((1 << SM0) | (1 << SM1))
+
+#define set_sleep_mode(mode) (SMCR = (uint8_t)((SMCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode)))
+#define sleep_enable() (SMCR |= (1 << SE))
+#define sleep_disable() (SMCR &= (uint8_t)~(1 << SE))
+#define sleep_cpu() (mm::sim::sleep())
+#define sleep_mode()     \
+    do                   \
+    {                    \
+        sleep_enable();  \
+        sleep_cpu();     \
+        sleep_disable(); \
+    } while (0)
+
+#endif // MM_SIM_AVR_SLEEP_H
@@ -0,0 +1,57 @@
+/**
+ * @file atomic.h
+ * @brief Host replacement for avr-libc's `<util/atomic.h>`.
+ */
+
+#ifndef MM_SIM_UTIL_ATOMIC_H
+#define MM_SIM_UTIL_ATOMIC_H
+
+#include <avr/io.h>
+
+namespace mm
+{
+    namespace sim
+    {
+        /**
+         * @brief Sets the I flag for one pass of the block, then restores or inverts it.
+         */
+        class AtomicGuard
+        {
+        private:
+            uint8_t sreg;    ///< SREG before the block.
+            bool restore;    ///< Restore SREG instead of forcing the flag.
+            bool inside;     ///< State of the I flag inside the block.
+            bool entered;    ///< Set after the first pass.
+
+        public:
+            AtomicGuard(bool restore, bool inside)
+                : sreg(SREG), restore(restore), inside(inside), entered(false)
+            {
+                SREG = inside ? (uint8_t)(sreg | (1 << SREG_I)) : (uint8_t)(sreg & ~(1 << SREG_I));
+            }
+
+            ~AtomicGuard()
+            {
+                // FORCEON leaves interrupts on after an atomic block, FORCEOFF off after a non-atomic one
+                SREG = restore ? sreg : inside ? (uint8_t)(SREG & ~(1 << SREG_I)) : (uint8_t)(SREG | (1 << SREG_I));
+            }
+
+            bool enter()
+            {
+                bool first = !entered;
+                entered = true;
+                return first;
+            }
+        };
+    }
+}
+
+#define ATOMIC_RESTORESTATE true
+#define ATOMIC_FORCEON false
+#define NONATOMIC_RESTORESTATE true
+#define NONATOMIC_FORCEOFF false
+
+#define ATOMIC_BLOCK(type) for (mm::sim::AtomicGuard mm_atomic_guard(type, false); mm_atomic_guard.enter();)
+#define NONATOMIC_BLOCK(type) for (mm::sim::AtomicGuard mm_atomic_guard(type, true); mm_atomic_guard.enter();)
+
+#endif // MM_SIM_UTIL_ATOMIC_H
@@ -0,0 +1,31 @@
+/**
+ * @file crc16.h
+ * @brief Host replacement for avr-libc's `<util/crc16.h>`.
+ */
+
+#ifndef MM_SIM_UTIL_CRC16_H
+#define MM_SIM_UTIL_CRC16_H
+
+#include <stdint.h>
+
+inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+    crc ^= data;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+#endif // MM_SIM_UTIL_CRC16_H
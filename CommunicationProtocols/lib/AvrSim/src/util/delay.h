@@ -0,0 +1,21 @@
+/**
+ * @file delay.h
+ * @brief Host replacement for avr-libc's `<util/delay.h>`; delays advance simulated time.
+ */
+
+#ifndef MM_SIM_UTIL_DELAY_H
+#define MM_SIM_UTIL_DELAY_H
+
+#include <avr/io.h>
+
+inline void _delay_ms(double ms)
+{
+    mm::sim::advance((uint64_t)(ms * (F_CPU / 1000.0)));
+}
+
+inline void _delay_us(double us)
+{
+    mm::sim::advance((uint64_t)(us * (F_CPU / 1000000.0)));
+}
+
+#endif // MM_SIM_UTIL_DELAY_H
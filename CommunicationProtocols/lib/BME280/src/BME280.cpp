@@ -0,0 +1,143 @@
+#include "BME280.h"
+#include <util/delay.h>
+
+#if BME280_CACHE_CALIBRATION
+BME280_CalibCache bme280_calib_cache[BME280_CACHE_SLOTS] EEMEM;
+#endif
+
+namespace
+{
+    // Registers of the BME280
+    constexpr uint8_t reg_id = 0xD0;
+    constexpr uint8_t reg_ctrl_hum = 0xF2;
+    constexpr uint8_t reg_status = 0xF3;
+    constexpr uint8_t reg_ctrl_meas = 0xF4;
+    constexpr uint8_t reg_config = 0xF5;
+    constexpr uint8_t reg_data = 0xF7;
+
+    constexpr uint8_t status_measuring = 1 << 3;
+    constexpr uint8_t mode_mask = 0b11;
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::readCalibrationData(uint8_t chip_id)
+{
+    BME280_CalibRaw raw;
+    uint8_t fingerprint[BME280_CALIB_FINGERPRINT_LEN];
+
+    // A cached record is only used if it was read from this very part
+    bool cached = bme280CalibrationCacheEnabled(cache_slot) &&
+                  transport.readBlock(BME280_CALIB_TP_REG, fingerprint, sizeof(fingerprint)) &&
+                  bme280LoadCachedCalibration(cache_slot, chip_id, fingerprint, raw);
+    if (!cached)
+    {
+        if (!transport.readBlock(BME280_CALIB_TP_REG, raw.tp, BME280_CALIB_TP_LEN) ||
+            !transport.readBlock(BME280_CALIB_H_REG, raw.h, BME280_CALIB_H_LEN))
+        {
+            return false;
+        }
+        bme280StoreCachedCalibration(cache_slot, chip_id, raw);
+    }
+
+    bme280ParseCalibration(raw, calib);
+    return true;
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::init(const BME280Settings &settings)
+{
+    uint8_t id = 0;
+
+    transport.init();
+    if (!transport.readBlock(reg_id, &id, 1) || id != BME280_CHIP_ID)
+    {
+        return false;
+    }
+    if (!readCalibrationData(id))
+    {
+        return false;
+    }
+
+    // ctrl_hum only takes effect with the following write of ctrl_meas, and config is
+    // written while the sensor still sleeps. Forced mode waits for startMeasurement().
+    this->settings = settings;
+    uint8_t ctrl_meas = settings.ctrl_meas;
+    if ((ctrl_meas & mode_mask) != (uint8_t)BME280Mode::Normal)
+    {
+        ctrl_meas &= ~mode_mask;
+    }
+    return transport.writeRegister(reg_ctrl_hum, settings.ctrl_hum) &&
+           transport.writeRegister(reg_config, settings.config) &&
+           transport.writeRegister(reg_ctrl_meas, ctrl_meas);
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::startMeasurement()
+{
+    return transport.writeRegister(reg_ctrl_meas, (settings.ctrl_meas & ~mode_mask) | (uint8_t)BME280Mode::Forced);
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::measuring(bool &busy)
+{
+    uint8_t status = 0;
+
+    if (!transport.readBlock(reg_status, &status, 1))
+    {
+        return false;
+    }
+    busy = status & status_measuring;
+    return true;
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::measure()
+{
+    if (!startMeasurement())
+    {
+        return false;
+    }
+
+    // The measuring bit is only set once the conversion has begun, so the status is first
+    // read one interval after the start. The bus transfers add to each interval, so this
+    // bound is longer than the maximum measurement time.
+    bool busy = true;
+    for (uint32_t waited = 0; busy; waited += BME280_POLL_INTERVAL_US)
+    {
+        if (waited >= measurementTime())
+        {
+            return false;
+        }
+        _delay_us(BME280_POLL_INTERVAL_US);
+        if (!measuring(busy))
+        {
+            return false;
+        }
+    }
+    return readRawData();
+}
+
+template <typename Transport>
+bool mm::BME280<Transport>::readRawData()
+{
+    uint8_t data[8];
+
+    // press_msb..hum_lsb in one transaction
+    if (!transport.readBlock(reg_data, data, sizeof(data)))
+    {
+        return false;
+    }
+
+    int32_t press_raw = ((uint32_t)data[0] << 12) | ((uint32_t)data[1] << 4) | (data[2] >> 4);
+    int32_t temp_raw = ((uint32_t)data[3] << 12) | ((uint32_t)data[4] << 4) | (data[5] >> 4);
+    int32_t hum_raw = ((uint32_t)data[6] << 8) | data[7];
+
+    t_fine = bme280FineTemperature(calib, temp_raw);
+    temp = bme280Temperature(t_fine);
+    press = bme280Pressure(calib, t_fine, press_raw);
+    hum = bme280Humidity(calib, t_fine, hum_raw);
+    return true;
+}
+
+template class mm::BME280<mm::BME280I2C>;
+template class mm::BME280<mm::BME280SPI>;
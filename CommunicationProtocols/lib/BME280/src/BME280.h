@@ -0,0 +1,404 @@
+/**
+ * @file BME280.h
+ * @brief Driver for the Bosch BME280 humidity, pressure and temperature sensor.
+ *
+ * This file defines the `BME280` class template and the two transports it can use,
+ * `BME280I2C` and `BME280SPI`. The transport is a template parameter, so register
+ * accesses compile to direct calls into the bus driver without virtual dispatch, and
+ * each sensor keeps its own calibration and readings. Any number of sensors can share
+ * one bus:
+ *
+ * @code
+ * mm::I2C i2c(mm::Hz(400000UL));
+ * mm::BME280<mm::BME280I2C> indoor(mm::BME280I2C(i2c, 0x76), 0);
+ * mm::BME280<mm::BME280I2C> outdoor(mm::BME280I2C(i2c, 0x77), 1);
+ *
+ * i2c.init();
+ * if (indoor.init() && indoor.readRawData())
+ * {
+ *     int32_t temperature = indoor.getTemp();
+ * }
+ * @endcode
+ *
+ * In forced mode the sensor sleeps between samples and measures once per
+ * `startMeasurement()`. `measure()` waits for the result by polling the status register;
+ * an application with a scheduler can instead read the result `measurementTime()` later:
+ *
+ * @code
+ * outdoor.init(mm::bme280Settings(mm::BME280Mode::Forced));
+ * outdoor.measure();
+ * @endcode
+ */
+
+#ifndef BME280_H
+#define BME280_H
+
+#include <stdint.h>
+#include "I2C.h"
+#include "SPIBus.h"
+#include "bme280_calibration.h"
+#include "bme280_compensation.h"
+
+#define BME280_CHIP_ID 0x60 ///< Value of the id register (0xD0).
+
+#ifndef BME280_POLL_INTERVAL_US
+#define BME280_POLL_INTERVAL_US 500 ///< Delay between reads of the status register in `measure()`.
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Power mode, the mode bits of ctrl_meas.
+     */
+    enum class BME280Mode : uint8_t
+    {
+        Sleep = 0b00,  ///< No measurements, lowest power.
+        Forced = 0b01, ///< One measurement per `startMeasurement()`, then back to sleep.
+        Normal = 0b11  ///< Continuous measurements separated by the standby time.
+    };
+
+    /**
+     * @brief Number of samples averaged per measurement.
+     */
+    enum class BME280Oversampling : uint8_t
+    {
+        Skip, ///< Not measured, the output keeps its reset value.
+        X1,   ///< One sample.
+        X2,   ///< Two samples.
+        X4,   ///< Four samples.
+        X8,   ///< Eight samples.
+        X16   ///< Sixteen samples.
+    };
+
+    /**
+     * @brief Coefficient of the IIR filter applied to pressure and temperature.
+     */
+    enum class BME280Filter : uint8_t
+    {
+        Off, ///< No filtering.
+        X2,  ///< Coefficient 2.
+        X4,  ///< Coefficient 4.
+        X8,  ///< Coefficient 8.
+        X16  ///< Coefficient 16.
+    };
+
+    /**
+     * @brief Time between measurements in normal mode.
+     */
+    enum class BME280Standby : uint8_t
+    {
+        Ms0_5,  ///< 0.5 ms.
+        Ms62_5, ///< 62.5 ms.
+        Ms125,  ///< 125 ms.
+        Ms250,  ///< 250 ms.
+        Ms500,  ///< 500 ms.
+        Ms1000, ///< 1000 ms.
+        Ms10,   ///< 10 ms.
+        Ms20    ///< 20 ms.
+    };
+
+    /**
+     * @struct BME280Settings
+     * @brief Contents of the three control registers.
+     */
+    struct BME280Settings
+    {
+        uint8_t ctrl_hum;  ///< Humidity oversampling (0xF2).
+        uint8_t ctrl_meas; ///< Temperature and pressure oversampling and the mode (0xF4).
+        uint8_t config;    ///< Standby time and filter (0xF5).
+    };
+
+    /**
+     * @brief Returns the control register contents for the given configuration.
+     *
+     * The defaults are the settings of the example application: humidity x16, pressure
+     * and temperature x4, filter 8 and 1 s standby.
+     */
+    constexpr BME280Settings bme280Settings(BME280Mode mode,
+                                            BME280Oversampling temperature = BME280Oversampling::X4,
+                                            BME280Oversampling pressure = BME280Oversampling::X4,
+                                            BME280Oversampling humidity = BME280Oversampling::X16,
+                                            BME280Filter filter = BME280Filter::X8,
+                                            BME280Standby standby = BME280Standby::Ms1000)
+    {
+        return BME280Settings{(uint8_t)humidity,
+                              (uint8_t)((uint8_t)temperature << 5 | (uint8_t)pressure << 2 | (uint8_t)mode),
+                              (uint8_t)((uint8_t)standby << 5 | (uint8_t)filter << 2)};
+    }
+
+    namespace bme280
+    {
+        /**
+         * @brief Returns the number of samples of an osrs_x field, 0 for a skipped measurement.
+         */
+        constexpr uint8_t samples(uint8_t osrs)
+        {
+            return osrs == 0 ? 0 : osrs >= 5 ? 16 : 1 << (osrs - 1);
+        }
+
+        /**
+         * @brief Returns the maximum time of one pressure or humidity measurement in µs.
+         */
+        constexpr uint32_t channelTime(uint8_t osrs)
+        {
+            return samples(osrs) ? 2300UL * samples(osrs) + 575 : 0;
+        }
+    }
+
+    /**
+     * @brief Returns the maximum duration of one measurement in µs (datasheet section 9.1).
+     *
+     * 1.25 ms plus 2.3 ms per sample, and 0.575 ms for each of pressure and humidity when
+     * they are measured; e.g. 57.6 ms for the default settings of `bme280Settings()`.
+     */
+    constexpr uint32_t bme280MeasurementTime(const BME280Settings &settings)
+    {
+        return 1250 + 2300UL * bme280::samples(settings.ctrl_meas >> 5 & 0x07) +
+               bme280::channelTime(settings.ctrl_meas >> 2 & 0x07) + bme280::channelTime(settings.ctrl_hum & 0x07);
+    }
+
+    /**
+     * @class BME280I2C
+     * @brief Register access to a BME280 on an I2C bus.
+     */
+    class BME280I2C
+    {
+    private:
+        I2C &bus;        ///< Bus the sensor is attached to.
+        uint8_t address; ///< 7-bit address, 0x76 or 0x77 depending on SDO.
+
+    public:
+        /**
+         * @brief Constructs a transport for the sensor at the given address.
+         *
+         * @param bus The bus, initialized by its owner.
+         * @param address The 7-bit address of the sensor.
+         */
+        BME280I2C(I2C &bus, uint8_t address = 0x76)
+            : bus(bus), address(address) {}
+
+        /**
+         * @brief Nothing to prepare, the bus belongs to its owner.
+         */
+        void init() {}
+
+        /**
+         * @brief Writes one register.
+         *
+         * @return True if the sensor acknowledged the write.
+         */
+        bool writeRegister(uint8_t reg, uint8_t value)
+        {
+            return bus.write_register(address, reg, value) == I2CStatus::Ok;
+        }
+
+        /**
+         * @brief Reads consecutive registers in one transaction.
+         *
+         * @return True if the transfer succeeded.
+         */
+        bool readBlock(uint8_t reg, uint8_t *data, uint8_t len)
+        {
+            return bus.read_block(address, reg, data, len) == I2CStatus::Ok;
+        }
+    };
+
+    /**
+     * @class BME280SPI
+     * @brief Register access to a BME280 on an SPI bus (mode 0 or 3, up to 10 MHz).
+     *
+     * The default `SPIRegisterFormat` of `SPIDevice` (bit 7 set for reads) matches the
+     * BME280.
+     */
+    class BME280SPI
+    {
+    private:
+        SPIDevice &device; ///< Chip select and settings of the sensor.
+
+    public:
+        /**
+         * @brief Constructs a transport for the sensor behind the given device handle.
+         *
+         * @param device The device; its bus is initialized by its owner.
+         */
+        explicit BME280SPI(SPIDevice &device)
+            : device(device) {}
+
+        /**
+         * @brief Makes the chip select an output and deasserts it.
+         */
+        void init()
+        {
+            device.init();
+        }
+
+        /**
+         * @brief Writes one register.
+         *
+         * @return Always true, SPI has no acknowledge.
+         */
+        bool writeRegister(uint8_t reg, uint8_t value)
+        {
+            device.writeRegister(reg, value);
+            return true;
+        }
+
+        /**
+         * @brief Reads consecutive registers in one transfer.
+         *
+         * @return Always true, SPI has no acknowledge.
+         */
+        bool readBlock(uint8_t reg, uint8_t *data, uint8_t len)
+        {
+            device.readBlock(reg, data, len);
+            return true;
+        }
+    };
+
+    /**
+     * @class BME280
+     * @brief One BME280 sensor, accessed through `Transport`.
+     *
+     * `Transport` provides `init()`, `writeRegister(reg, value)` and
+     * `readBlock(reg, data, len)`, both returning true on success. The member functions
+     * are instantiated in BME280.cpp for `BME280I2C` and `BME280SPI`.
+     *
+     * @tparam Transport `BME280I2C` or `BME280SPI`.
+     */
+    template <typename Transport>
+    class BME280
+    {
+    private:
+        Transport transport;     ///< Register access to the sensor.
+        BME280_CalibData calib;  ///< Calibration coefficients of this sensor.
+        int32_t t_fine;          ///< Fine temperature of the last measurement.
+        int32_t temp;            ///< Temperature in 0.01 degrees Celsius.
+        uint32_t press;          ///< Pressure in Pa / 256.
+        uint32_t hum;            ///< Humidity in %RH / 1024.
+        uint8_t cache_slot;      ///< EEPROM calibration cache slot.
+        BME280Settings settings; ///< Control registers written by `init()`.
+
+        /**
+         * @brief Loads the calibration from the EEPROM cache or from the sensor.
+         *
+         * @return False if the sensor could not be read.
+         */
+        bool readCalibrationData(uint8_t chip_id);
+
+    public:
+        /**
+         * @brief Constructs a sensor.
+         *
+         * @param transport Register access to the sensor.
+         * @param cache_slot EEPROM calibration cache slot, different for each sensor;
+         *                   from `BME280_CACHE_SLOTS` on the calibration is not cached.
+         */
+        BME280(const Transport &transport, uint8_t cache_slot = 0)
+            : transport(transport), calib(), t_fine(0), temp(0), press(0), hum(0), cache_slot(cache_slot),
+              settings(bme280Settings(BME280Mode::Normal)) {}
+
+        /**
+         * @brief Checks the chip ID, reads the calibration and configures the sensor.
+         *
+         * In normal mode the sensor starts measuring; in forced mode it stays asleep until
+         * `startMeasurement()`. The bus must be initialized first.
+         *
+         * @param settings The configuration, by default normal mode with humidity x16,
+         *                 pressure and temperature x4, IIR filter 8 and 1 s standby.
+         * @return True if a BME280 answered.
+         */
+        bool init(const BME280Settings &settings = bme280Settings(BME280Mode::Normal));
+
+        /**
+         * @brief Starts one measurement in forced mode.
+         *
+         * The result can be read with `readRawData()` after `measurementTime()` or once
+         * `measuring()` reports that the conversion has finished. The sensor goes back to
+         * sleep by itself.
+         *
+         * @return False if the sensor did not acknowledge.
+         */
+        bool startMeasurement();
+
+        /**
+         * @brief Checks the measuring bit of the status register (0xF3).
+         *
+         * @param busy Set to true while a conversion is running; left unchanged when the
+         *             status could not be read.
+         * @return False if the status could not be read.
+         */
+        bool measuring(bool &busy);
+
+        /**
+         * @brief Takes one forced-mode measurement and waits for it.
+         *
+         * Polls `measuring()` every `BME280_POLL_INTERVAL_US`, starting one interval after
+         * the measurement was started, so it returns as soon as the sensor is done, at the
+         * latest after `measurementTime()`.
+         *
+         * @return False if a transfer failed or the sensor was still busy after the maximum
+         *         measurement time; the previous readings are kept.
+         */
+        bool measure();
+
+        /**
+         * @brief Returns the maximum duration of one measurement with the current settings in µs.
+         */
+        uint32_t measurementTime() const
+        {
+            return bme280MeasurementTime(settings);
+        }
+
+        /**
+         * @brief Fetches and compensates the latest measurement.
+         *
+         * All eight data registers are read in one burst, so the three values come from
+         * the same measurement.
+         *
+         * @return False if the transfer failed; the previous readings are kept.
+         */
+        bool readRawData();
+
+        /**
+         * @brief Returns the temperature in 0.01 degrees Celsius, e.g. 2315 for 23.15 C.
+         */
+        int32_t getTemp() const
+        {
+            return temp;
+        }
+
+        /**
+         * @brief Returns the pressure in Pa / 256, e.g. 24674867 for 963.86 hPa.
+         */
+        uint32_t getPress() const
+        {
+            return press;
+        }
+
+        /**
+         * @brief Returns the humidity in %RH / 1024, e.g. 47445 for 46.33 %RH.
+         */
+        uint32_t getHum() const
+        {
+            return hum;
+        }
+
+        /**
+         * @brief Returns the calibration coefficients read by `init()`.
+         */
+        const BME280_CalibData &calibration() const
+        {
+            return calib;
+        }
+
+        /**
+         * @brief Returns the fine temperature of the last measurement, 5120 per degree Celsius.
+         */
+        int32_t fineTemperature() const
+        {
+            return t_fine;
+        }
+    };
+}
+
+#endif // BME280_H
@@ -0,0 +1,227 @@
+#ifndef BME280_CALIBRATION_H
+#define BME280_CALIBRATION_H
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include <string.h>
+
+// Cache the calibration data in EEPROM unless disabled with -D BME280_CACHE_CALIBRATION=0
+#ifndef BME280_CACHE_CALIBRATION
+#define BME280_CACHE_CALIBRATION 1
+#endif
+
+// Number of calibration records in EEPROM, one per sensor on the node
+#ifndef BME280_CACHE_SLOTS
+#define BME280_CACHE_SLOTS 3
+#endif
+
+// Calibration register blocks of the BME280
+#define BME280_CALIB_TP_REG 0x88 // dig_T1..dig_H1, 0x88..0xA1
+#define BME280_CALIB_TP_LEN 26
+#define BME280_CALIB_H_REG 0xE1 // dig_H2..dig_H6, 0xE1..0xE7
+#define BME280_CALIB_H_LEN 7
+
+// dig_T1..dig_T3 (0x88..0x8D) are trimmed per part and identify the sensor a record belongs to
+#define BME280_CALIB_FINGERPRINT_LEN 6
+
+// Marks a valid calibration record in EEPROM
+#define BME280_CALIB_CACHE_MAGIC 0xB2
+
+/**
+ * @brief Calibration registers exactly as they are laid out in the sensor.
+ */
+struct __attribute__((packed)) BME280_CalibRaw
+{
+    uint8_t tp[BME280_CALIB_TP_LEN]; // 0x88..0xA1
+    uint8_t h[BME280_CALIB_H_LEN];   // 0xE1..0xE7
+};
+
+/**
+ * @brief Calibration coefficients used by the compensation formulas.
+ */
+struct BME280_CalibData
+{
+    uint16_t dig_T1;
+    int16_t dig_T2, dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+    uint8_t dig_H1, dig_H3;
+    int16_t dig_H2, dig_H4, dig_H5, dig_H6;
+};
+
+/**
+ * @brief Calibration record stored in EEPROM.
+ */
+struct __attribute__((packed)) BME280_CalibCache
+{
+    uint8_t magic;       // BME280_CALIB_CACHE_MAGIC when the record is valid
+    uint8_t chip_id;     // Chip ID of the sensor the data was read from
+    BME280_CalibRaw raw; // Calibration registers
+    uint8_t crc;         // CRC-8 over chip_id and raw
+};
+
+#if BME280_CACHE_CALIBRATION
+// Calibration records, defined in BME280.cpp
+extern BME280_CalibCache bme280_calib_cache[BME280_CACHE_SLOTS];
+#endif
+
+/**
+ * @brief Combines two little-endian bytes into a 16-bit value.
+ * @param data Pointer to the low byte.
+ * @return The combined value.
+ */
+inline uint16_t bme280ReadLE16(const uint8_t *data)
+{
+    return ((uint16_t)data[1] << 8) | data[0];
+}
+
+/**
+ * @brief Converts the raw calibration registers into compensation coefficients.
+ * @param raw Calibration registers read from the sensor or the EEPROM cache.
+ * @param calib Structure that receives the coefficients.
+ */
+inline void bme280ParseCalibration(const BME280_CalibRaw &raw, BME280_CalibData &calib)
+{
+    calib.dig_T1 = bme280ReadLE16(&raw.tp[0]);
+    calib.dig_T2 = (int16_t)bme280ReadLE16(&raw.tp[2]);
+    calib.dig_T3 = (int16_t)bme280ReadLE16(&raw.tp[4]);
+
+    calib.dig_P1 = bme280ReadLE16(&raw.tp[6]);
+    calib.dig_P2 = (int16_t)bme280ReadLE16(&raw.tp[8]);
+    calib.dig_P3 = (int16_t)bme280ReadLE16(&raw.tp[10]);
+    calib.dig_P4 = (int16_t)bme280ReadLE16(&raw.tp[12]);
+    calib.dig_P5 = (int16_t)bme280ReadLE16(&raw.tp[14]);
+    calib.dig_P6 = (int16_t)bme280ReadLE16(&raw.tp[16]);
+    calib.dig_P7 = (int16_t)bme280ReadLE16(&raw.tp[18]);
+    calib.dig_P8 = (int16_t)bme280ReadLE16(&raw.tp[20]);
+    calib.dig_P9 = (int16_t)bme280ReadLE16(&raw.tp[22]);
+
+    // 0xA0 is reserved, dig_H1 lives at 0xA1
+    calib.dig_H1 = raw.tp[25];
+    calib.dig_H2 = (int16_t)bme280ReadLE16(&raw.h[0]);
+    calib.dig_H3 = raw.h[2];
+    // dig_H4 and dig_H5 are signed 12-bit values sharing the nibbles of 0xE5
+    calib.dig_H4 = (int16_t)((int8_t)raw.h[3] * 16) | (raw.h[4] & 0x0F);
+    calib.dig_H5 = (int16_t)((int8_t)raw.h[5] * 16) | (raw.h[4] >> 4);
+    calib.dig_H6 = (int8_t)raw.h[6];
+}
+
+/**
+ * @brief Computes the checksum of a calibration record.
+ * @param chip_id Chip ID stored in the record.
+ * @param raw Calibration registers stored in the record.
+ * @return CRC-8 of the chip ID and the calibration registers.
+ */
+inline uint8_t bme280CalibrationCrc(uint8_t chip_id, const BME280_CalibRaw &raw)
+{
+    const uint8_t *bytes = (const uint8_t *)&raw;
+    uint8_t crc = _crc8_ccitt_update(0, chip_id);
+    for (uint8_t i = 0; i < sizeof(raw); i++)
+    {
+        crc = _crc8_ccitt_update(crc, bytes[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief Checks whether a slot of the EEPROM cache is in use at all.
+ * @param slot Cache slot of the sensor.
+ * @return False if caching is disabled or the slot is beyond BME280_CACHE_SLOTS.
+ */
+inline bool bme280CalibrationCacheEnabled(uint8_t slot)
+{
+    return BME280_CACHE_CALIBRATION && slot < BME280_CACHE_SLOTS;
+}
+
+/**
+ * @brief Loads the calibration registers from the EEPROM cache.
+ *
+ * Each sensor on the node uses its own slot. Every BME280 reports the same chip ID, so a
+ * record only matches if its first BME280_CALIB_FINGERPRINT_LEN calibration bytes equal
+ * the ones just read from the sensor; a replaced sensor is detected this way and its
+ * calibration is read again.
+ *
+ * @param slot Cache slot of the sensor; slots from BME280_CACHE_SLOTS on are never cached.
+ * @param chip_id Chip ID read from the sensor.
+ * @param fingerprint Registers 0x88.. read from the sensor, BME280_CALIB_FINGERPRINT_LEN bytes.
+ * @param raw Structure that receives the calibration registers.
+ * @return True if a valid record for this sensor was found.
+ */
+inline bool bme280LoadCachedCalibration(uint8_t slot, uint8_t chip_id, const uint8_t *fingerprint,
+                                        BME280_CalibRaw &raw)
+{
+#if BME280_CACHE_CALIBRATION
+    if (slot >= BME280_CACHE_SLOTS)
+    {
+        return false;
+    }
+
+    BME280_CalibCache cache;
+    eeprom_read_block(&cache, &bme280_calib_cache[slot], sizeof(cache));
+
+    if (cache.magic != BME280_CALIB_CACHE_MAGIC || cache.chip_id != chip_id ||
+        cache.crc != bme280CalibrationCrc(cache.chip_id, cache.raw) ||
+        memcmp(cache.raw.tp, fingerprint, BME280_CALIB_FINGERPRINT_LEN) != 0)
+    {
+        return false;
+    }
+
+    raw = cache.raw;
+    return true;
+#else
+    (void)slot;
+    (void)chip_id;
+    (void)fingerprint;
+    (void)raw;
+    return false;
+#endif
+}
+
+/**
+ * @brief Stores the calibration registers in the EEPROM cache.
+ *
+ * Only changed bytes are written, so storing the same data again does not wear the EEPROM.
+ *
+ * @param slot Cache slot of the sensor.
+ * @param chip_id Chip ID read from the sensor.
+ * @param raw Calibration registers read from the sensor.
+ */
+inline void bme280StoreCachedCalibration(uint8_t slot, uint8_t chip_id, const BME280_CalibRaw &raw)
+{
+#if BME280_CACHE_CALIBRATION
+    if (slot >= BME280_CACHE_SLOTS)
+    {
+        return;
+    }
+
+    BME280_CalibCache cache;
+    cache.magic = BME280_CALIB_CACHE_MAGIC;
+    cache.chip_id = chip_id;
+    cache.raw = raw;
+    cache.crc = bme280CalibrationCrc(chip_id, raw);
+    eeprom_update_block(&cache, &bme280_calib_cache[slot], sizeof(cache));
+#else
+    (void)slot;
+    (void)chip_id;
+    (void)raw;
+#endif
+}
+
+/**
+ * @brief Marks a slot of the EEPROM cache as empty so the next start reads the sensor again.
+ * @param slot Cache slot of the sensor.
+ */
+inline void bme280InvalidateCalibrationCache(uint8_t slot)
+{
+#if BME280_CACHE_CALIBRATION
+    if (slot < BME280_CACHE_SLOTS)
+    {
+        eeprom_update_byte(&bme280_calib_cache[slot].magic, 0xFF);
+    }
+#else
+    (void)slot;
+#endif
+}
+
+#endif // BME280_CALIBRATION_H
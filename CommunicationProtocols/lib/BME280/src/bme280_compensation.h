@@ -0,0 +1,178 @@
+#ifndef BME280_COMPENSATION_H
+#define BME280_COMPENSATION_H
+
+#include <stdint.h>
+#include "bme280_calibration.h"
+
+// Pressure kernel: 1 for the 64-bit formula (exact, Pa/256 resolution), 0 for the 32-bit
+// formula of the datasheet (1 Pa resolution, no 64-bit library code on the AVR)
+#ifndef BME280_PRESSURE_INT64
+#define BME280_PRESSURE_INT64 1
+#endif
+
+// Largest difference in Pa of the 32-bit pressure kernel from the 64-bit one, below the
+// +-12 Pa relative accuracy of the sensor; checked by bench/host/compensation_check.cpp
+#define BME280_PRESSURE_INT32_TOLERANCE_PA 8
+
+/**
+ * @brief Computes the fine temperature shared by all compensation formulas.
+ * @param calib Calibration coefficients.
+ * @param adc_T Raw temperature, 20 bits.
+ * @return The fine temperature t_fine, 5120 per degree Celsius.
+ */
+inline int32_t bme280FineTemperature(const BME280_CalibData &calib, int32_t adc_T)
+{
+    int32_t var1, var2;
+
+    var1 = ((((adc_T >> 3) - ((int32_t)calib.dig_T1 << 1))) * ((int32_t)calib.dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)calib.dig_T1))) >> 12) *
+            ((int32_t)calib.dig_T3)) >> 14;
+    return var1 + var2;
+}
+
+/**
+ * @brief Converts the fine temperature to 0.01 degrees Celsius.
+ * @param t_fine Fine temperature from bme280FineTemperature().
+ * @return Temperature in 0.01 degrees Celsius, e.g. 2508 for 25.08 C.
+ */
+inline int32_t bme280Temperature(int32_t t_fine)
+{
+    return (t_fine * 5 + 128) >> 8;
+}
+
+/**
+ * @brief Compensates the raw pressure with 64-bit arithmetic.
+ * @param calib Calibration coefficients.
+ * @param t_fine Fine temperature of the same measurement.
+ * @param adc_P Raw pressure, 20 bits.
+ * @return Pressure in Pa as Q24.8 (Pa * 256), 0 for invalid calibration data.
+ */
+inline uint32_t bme280PressureInt64(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_P)
+{
+    int64_t var1, var2, p;
+
+    var1 = (int64_t)t_fine - 128000;
+    var2 = var1 * var1 * (int64_t)calib.dig_P6;
+    var2 = var2 + ((var1 * (int64_t)calib.dig_P5) << 17);
+    var2 = var2 + ((int64_t)calib.dig_P4 << 35);
+    var1 = ((var1 * var1 * (int64_t)calib.dig_P3) >> 8) + ((var1 * (int64_t)calib.dig_P2) << 12);
+    var1 = ((((int64_t)1) << 47) + var1) * (int64_t)calib.dig_P1 >> 33;
+
+    if (var1 == 0)
+    {
+        return 0; // Avoid division by zero
+    }
+
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = ((int64_t)calib.dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)calib.dig_P8 * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + ((int64_t)calib.dig_P7 << 4);
+    return (uint32_t)p;
+}
+
+/**
+ * @brief Compensates the raw pressure with the 32-bit formula of the datasheet.
+ *
+ * Uses one 32-bit division and no 64-bit arithmetic. The result differs from
+ * bme280PressureInt64() by at most BME280_PRESSURE_INT32_TOLERANCE_PA between 300 and
+ * 1100 hPa and -40 to 85 C.
+ *
+ * @param calib Calibration coefficients.
+ * @param t_fine Fine temperature of the same measurement.
+ * @param adc_P Raw pressure, 20 bits.
+ * @return Pressure in Pa, 0 for invalid calibration data.
+ */
+inline uint32_t bme280PressureInt32(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_P)
+{
+    int32_t var1, var2, square;
+    uint32_t p;
+
+    var1 = (t_fine >> 1) - (int32_t)64000;
+    square = (var1 >> 2) * (var1 >> 2);
+    var2 = ((square >> 11) * (int32_t)calib.dig_P6) + ((var1 * (int32_t)calib.dig_P5) << 1);
+    var2 = (var2 >> 2) + ((int32_t)calib.dig_P4 << 16);
+    var1 = ((((int32_t)calib.dig_P3 * (square >> 13)) >> 3) + (((int32_t)calib.dig_P2 * var1) >> 1)) >> 18;
+    var1 = ((32768 + var1) * (int32_t)calib.dig_P1) >> 15;
+
+    if (var1 == 0)
+    {
+        return 0; // Avoid division by zero
+    }
+
+    p = ((uint32_t)((int32_t)1048576 - adc_P) - (uint32_t)(var2 >> 12)) * 3125;
+    if (p < 0x80000000UL)
+    {
+        p = (p << 1) / (uint32_t)var1;
+    }
+    else
+    {
+        p = (p / (uint32_t)var1) * 2;
+    }
+
+    var1 = ((int32_t)calib.dig_P9 * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(p >> 2) * (int32_t)calib.dig_P8) >> 13;
+    return (uint32_t)((int32_t)p + ((var1 + var2 + calib.dig_P7) >> 4));
+}
+
+/**
+ * @brief Compensates the raw pressure with the kernel selected by BME280_PRESSURE_INT64.
+ * @param calib Calibration coefficients.
+ * @param t_fine Fine temperature of the same measurement.
+ * @param adc_P Raw pressure, 20 bits.
+ * @return Pressure in Pa as Q24.8 (Pa * 256); the 32-bit kernel leaves the fraction zero.
+ */
+inline uint32_t bme280Pressure(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_P)
+{
+#if BME280_PRESSURE_INT64
+    return bme280PressureInt64(calib, t_fine, adc_P);
+#else
+    return bme280PressureInt32(calib, t_fine, adc_P) << 8;
+#endif
+}
+
+/**
+ * @brief Compensates the raw humidity.
+ * @param calib Calibration coefficients.
+ * @param t_fine Fine temperature of the same measurement.
+ * @param adc_H Raw humidity, 16 bits.
+ * @return Humidity in %RH as Q22.10 (%RH * 1024).
+ */
+inline uint32_t bme280Humidity(const BME280_CalibData &calib, int32_t t_fine, int32_t adc_H)
+{
+    int32_t v_x1_u32r;
+
+    v_x1_u32r = (t_fine - ((int32_t)76800));
+    v_x1_u32r = (((((adc_H << 14) - (((int32_t)calib.dig_H4) << 20) - (((int32_t)calib.dig_H5) * v_x1_u32r)) +
+                ((int32_t)16384)) >> 15) * (((((((v_x1_u32r * ((int32_t)calib.dig_H6)) >> 10) * (((v_x1_u32r *
+                ((int32_t)calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) + ((int32_t)2097152)) *
+                ((int32_t)calib.dig_H2) + 8192) >> 14));
+
+    // Apply the limits to the humidity value
+    v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)calib.dig_H1)) >> 4));
+    v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+    v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+    return (uint32_t)(v_x1_u32r >> 12);
+}
+
+/**
+ * @brief Converts a pressure reading to 0.01 hPa (= Pa), rounded.
+ * @param press Pressure in Pa / 256.
+ * @return Pressure in 0.01 hPa.
+ */
+inline uint32_t pressureCentiHpa(uint32_t press)
+{
+    return (press + 128) >> 8;
+}
+
+/**
+ * @brief Converts a humidity reading to 0.01 %RH, rounded.
+ * @param hum Humidity in %RH / 1024.
+ * @return Humidity in 0.01 %RH.
+ */
+inline uint32_t humidityCentiPercent(uint32_t hum)
+{
+    return (hum * 100 + 512) >> 10;
+}
+
+#endif // BME280_COMPENSATION_H
@@ -0,0 +1,158 @@
+/**
+ * @file BaudRate.h
+ * @brief Baud rate register calculation for the AVR USART.
+ *
+ * This file defines `BaudSetting` and the `constexpr` helpers that choose the UBRR value
+ * and the U2X double-speed bit for a requested speed. When the speed is a constant the
+ * whole calculation is done by the compiler.
+ */
+
+#ifndef BAUD_RATE_H
+#define BAUD_RATE_H
+
+#include <stdint.h>
+
+namespace mm
+{
+    /**
+     * @struct BaudSetting
+     * @brief Register values that produce a USART speed.
+     */
+    struct BaudSetting
+    {
+        uint16_t ubrr; ///< Value for the UBRRn register.
+        bool u2x;      ///< Whether the U2Xn double-speed bit is set.
+    };
+
+    namespace baud
+    {
+        constexpr uint16_t ubrr_max = 4095; ///< Largest value accepted by the 12-bit UBRRn register.
+
+        /**
+         * @brief Returns the clock divisor of the selected speed mode (16 or 8 with U2X).
+         */
+        constexpr uint32_t divisor(bool u2x)
+        {
+            return u2x ? 8UL : 16UL;
+        }
+
+        /**
+         * @brief Limits a UBRR value to the range of the register.
+         */
+        constexpr uint16_t clamp(uint32_t ubrr)
+        {
+            return ubrr > ubrr_max ? ubrr_max : (uint16_t)ubrr;
+        }
+
+        /**
+         * @brief Returns the rounded UBRR value for a speed, before the final decrement.
+         */
+        constexpr uint32_t roundedDivider(uint32_t f_cpu, uint32_t speed, bool u2x)
+        {
+            return (f_cpu + divisor(u2x) * speed / 2) / (divisor(u2x) * speed);
+        }
+
+        /**
+         * @brief Returns the UBRR value closest to the requested speed.
+         *
+         * The division is rounded to nearest instead of truncated, which halves the
+         * worst-case error compared with the classic `F_CPU / (16 * speed) - 1` formula.
+         */
+        constexpr uint16_t ubrr(uint32_t f_cpu, uint32_t speed, bool u2x)
+        {
+            return roundedDivider(f_cpu, speed, u2x) == 0 ? 0 : clamp(roundedDivider(f_cpu, speed, u2x) - 1);
+        }
+
+        /**
+         * @brief Returns the speed produced by a UBRR value, rounded to the nearest baud.
+         */
+        constexpr uint32_t achieved(uint32_t f_cpu, uint16_t ubrr, bool u2x)
+        {
+            return (f_cpu + divisor(u2x) * (ubrr + 1UL) / 2) / (divisor(u2x) * (ubrr + 1UL));
+        }
+
+        /**
+         * @brief Limits an error value to +/-100 %.
+         */
+        constexpr int16_t saturate(int32_t error)
+        {
+            return error > 10000 ? 10000 : (error < -10000 ? -10000 : (int16_t)error);
+        }
+
+        /**
+         * @brief Scales a speed difference to hundredths of a percent.
+         *
+         * Large speeds are divided down first so the product stays within 32 bits.
+         */
+        constexpr int16_t scaled(int32_t difference, uint32_t speed)
+        {
+            return speed < 0x10000UL ? saturate(difference * 10000L / (int32_t)speed)
+                                     : saturate(difference * 100L / (int32_t)(speed / 100));
+        }
+
+        /**
+         * @brief Returns the relative error between two speeds in hundredths of a percent.
+         *
+         * Errors of 100 % or more are reported as 100 %.
+         */
+        constexpr int16_t error(uint32_t achieved, uint32_t speed)
+        {
+            return achieved >= 2 * speed ? 10000 : scaled((int32_t)achieved - (int32_t)speed, speed);
+        }
+
+        /**
+         * @brief Returns the absolute error of a speed mode in hundredths of a percent.
+         */
+        constexpr int16_t absoluteError(uint32_t f_cpu, uint32_t speed, bool u2x)
+        {
+            return error(achieved(f_cpu, ubrr(f_cpu, speed, u2x), u2x), speed) < 0
+                       ? -error(achieved(f_cpu, ubrr(f_cpu, speed, u2x), u2x), speed)
+                       : error(achieved(f_cpu, ubrr(f_cpu, speed, u2x), u2x), speed);
+        }
+    }
+
+    /**
+     * @brief Chooses the register values that come closest to the requested speed.
+     *
+     * Both the normal (divide by 16) and the double-speed (divide by 8) mode are tried and
+     * the one with the lower error wins. Normal mode is kept on a tie, because it samples
+     * each bit three times and tolerates more clock mismatch.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param speed The requested speed in baud.
+     * @return The UBRR value and U2X bit to program.
+     */
+    constexpr BaudSetting baudSetting(uint32_t f_cpu, uint32_t speed)
+    {
+        return baud::absoluteError(f_cpu, speed, true) < baud::absoluteError(f_cpu, speed, false)
+                   ? BaudSetting{baud::ubrr(f_cpu, speed, true), true}
+                   : BaudSetting{baud::ubrr(f_cpu, speed, false), false};
+    }
+
+    /**
+     * @brief Returns the speed produced by a register setting.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param setting The register setting.
+     * @return The achieved speed in baud.
+     */
+    constexpr uint32_t achievedBaud(uint32_t f_cpu, BaudSetting setting)
+    {
+        return baud::achieved(f_cpu, setting.ubrr, setting.u2x);
+    }
+
+    /**
+     * @brief Returns the error of a register setting relative to the requested speed.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param setting The register setting.
+     * @param speed The requested speed in baud.
+     * @return The error in hundredths of a percent, e.g. 213 for +2.13 %.
+     */
+    constexpr int16_t baudError(uint32_t f_cpu, BaudSetting setting, uint32_t speed)
+    {
+        return baud::error(achievedBaud(f_cpu, setting), speed);
+    }
+}
+
+#endif // BAUD_RATE_H
@@ -0,0 +1,62 @@
+#include "Cobs.h"
+
+uint8_t mm::cobsEncode(const uint8_t *in, uint8_t len, uint8_t *out)
+{
+    uint8_t code_index = 0;
+    uint8_t write = 1;
+    uint8_t code = 1;
+
+    for (uint8_t i = 0; i < len; i++)
+    {
+        if (in[i] == 0)
+        {
+            out[code_index] = code;
+            code_index = write++;
+            code = 1;
+            continue;
+        }
+
+        out[write++] = in[i];
+        if (++code == 0xFF)
+        {
+            out[code_index] = code;
+            code_index = write++;
+            code = 1;
+        }
+    }
+
+    out[code_index] = code;
+    return write;
+}
+
+uint8_t mm::cobsDecode(const uint8_t *in, uint8_t len, uint8_t *out)
+{
+    uint8_t read = 0;
+    uint8_t write = 0;
+
+    while (read < len)
+    {
+        uint8_t code = in[read++];
+        if (code == 0)
+        {
+            return 0;
+        }
+
+        for (uint8_t i = 1; i < code; i++)
+        {
+            if (read >= len || in[read] == 0)
+            {
+                return 0;
+            }
+            out[write++] = in[read++];
+        }
+
+        // Every block but the last and the full ones stands for a zero
+        if (code != 0xFF && read < len)
+        {
+            out[write++] = 0;
+        }
+    }
+
+    return write;
+}
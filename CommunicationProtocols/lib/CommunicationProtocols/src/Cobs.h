@@ -0,0 +1,48 @@
+/**
+ * @file Cobs.h
+ * @brief Consistent Overhead Byte Stuffing for framing binary data on a byte stream.
+ *
+ * COBS removes every zero byte from a frame at a cost of one byte per 254, so a single
+ * 0x00 can mark the end of each frame. A receiver that loses bytes resynchronises at the
+ * next zero.
+ */
+
+#ifndef COBS_H
+#define COBS_H
+
+#include <stdint.h>
+
+namespace mm
+{
+    /**
+     * @brief Returns the largest encoded size of `len` bytes, without the delimiter.
+     */
+    constexpr uint8_t cobsMaxEncodedLength(uint8_t len)
+    {
+        return len + len / 254 + 1;
+    }
+
+    /**
+     * @brief Encodes a buffer with COBS.
+     *
+     * The trailing zero delimiter is not written.
+     *
+     * @param in The bytes to encode, at most 253.
+     * @param len Number of bytes.
+     * @param out Buffer of at least `cobsMaxEncodedLength(len)` bytes, not overlapping `in`.
+     * @return The number of bytes written to `out`.
+     */
+    uint8_t cobsEncode(const uint8_t *in, uint8_t len, uint8_t *out);
+
+    /**
+     * @brief Decodes a COBS frame.
+     *
+     * @param in The encoded bytes without the zero delimiter.
+     * @param len Number of encoded bytes.
+     * @param out Buffer of at least `len` bytes; it may be the same as `in`.
+     * @return The number of decoded bytes, 0 if the frame is malformed or empty.
+     */
+    uint8_t cobsDecode(const uint8_t *in, uint8_t len, uint8_t *out);
+}
+
+#endif // COBS_H
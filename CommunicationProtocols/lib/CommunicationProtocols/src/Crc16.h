@@ -0,0 +1,65 @@
+/**
+ * @file Crc16.h
+ * @brief CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) for frame checks.
+ *
+ * On AVR the byte update uses `_crc_xmodem_update()` from avr-libc, which implements the
+ * same polynomial; elsewhere a portable bitwise version is used, so host tools compute
+ * identical checksums.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Initial value of the CRC-16/CCITT register.
+     */
+    constexpr uint16_t crc16_init = 0xFFFF;
+
+    /**
+     * @brief Adds one byte to a CRC-16/CCITT.
+     *
+     * @param crc The CRC so far, `crc16_init` for the first byte.
+     * @param data The next byte.
+     * @return The updated CRC.
+     */
+    inline uint16_t crc16Update(uint16_t crc, uint8_t data)
+    {
+#if defined(__AVR__)
+        return _crc_xmodem_update(crc, data);
+#else
+        crc ^= (uint16_t)data << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+        return crc;
+#endif
+    }
+
+    /**
+     * @brief Computes the CRC-16/CCITT of a buffer.
+     *
+     * @param data The bytes to check.
+     * @param len Number of bytes.
+     * @return The CRC, 0x29B1 for the ASCII string "123456789".
+     */
+    inline uint16_t crc16(const uint8_t *data, uint8_t len)
+    {
+        uint16_t crc = crc16_init;
+        for (uint8_t i = 0; i < len; i++)
+        {
+            crc = crc16Update(crc, data[i]);
+        }
+        return crc;
+    }
+}
+
+#endif // CRC16_H
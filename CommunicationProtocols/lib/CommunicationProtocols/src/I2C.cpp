@@ -1,136 +1,605 @@
 #include "I2C.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <util/twi.h>
+#include "Register.h"
+#include "RingBuffer.h"
 
-#define BITRATE(TWSR) ((F_CPU / SCL_CLK) - 16) / (2 * ((1 << ((TWSR) & 0x03)) * (1 << ((TWSR) & 0x03))))
+// Each polling iteration takes roughly this many CPU cycles
+#define I2C_POLL_CYCLES 8
+#define I2C_TIMEOUT_LOOPS ((F_CPU / 1000000UL) * I2C_TIMEOUT_US / I2C_POLL_CYCLES)
 
-#ifndef SCL_CLK
-#define SCL_CLK 100000UL
+// Pins used by the bus recovery
+#ifndef I2C_PORT
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega32U4__)
+#define I2C_PORT PORTD
+#define I2C_DDR DDRD
+#define I2C_PIN PIND
+#define I2C_SDA 1
+#define I2C_SCL 0
+#else
+#define I2C_PORT PORTC
+#define I2C_DDR DDRC
+#define I2C_PIN PINC
+#define I2C_SDA PC4
+#define I2C_SCL PC5
+#endif
 #endif
 
-void mm::I2C::init()
+// TWCR values used by the interrupt-driven engine
+#define TWCR_ASYNC ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_ASYNC_ACK (TWCR_ASYNC | (1 << TWEA))
+#define TWCR_ASYNC_START (TWCR_ASYNC | (1 << TWSTA))
+
+namespace
 {
-    switch (prescaling)
+    /**
+     * @brief State of the interrupt-driven master engine.
+     */
+    struct AsyncState
+    {
+        mm::I2CTransaction *volatile current; ///< Transaction on the bus, nullptr when idle.
+        uint8_t index;                        ///< Bytes written or read in the current phase.
+        bool reading;                         ///< True after the repeated START for the read phase.
+        mm::RingBuffer<mm::I2CTransaction *, I2C_QUEUE_SIZE> queue; ///< Transactions waiting for the bus.
+        volatile uint8_t progress;            ///< Incremented on every TWI interrupt.
+    };
+
+    AsyncState async_state;
+
+    static_assert(I2C_TIMEOUT_LOOPS <= 0xFFFF, "I2C_TIMEOUT_US is too long");
+
+    /**
+     * @brief Waits for TWINT with a time limit.
+     *
+     * @return True if the hardware finished the current step in time.
+     */
+    bool waitForInterruptFlag()
+    {
+        for (uint16_t i = 0; i < (uint16_t)I2C_TIMEOUT_LOOPS; i++)
+        {
+            if (TWCR & (1 << TWINT))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Waits with a time limit until the hardware has put a requested STOP on the bus.
+     *
+     * TWSTO stays set until the STOP condition has been sent; a START requested before that
+     * is not issued and TWINT never rises.
+     *
+     * @return True if no STOP is pending.
+     */
+    bool waitForStop()
     {
-    case 1:
-        TWSR = 0x0;
+        for (uint16_t i = 0; i < (uint16_t)I2C_TIMEOUT_LOOPS; i++)
+        {
+            if (!(TWCR & (1 << TWSTO)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Maps a TWI status code that was not expected to an `I2CStatus`.
+     */
+    mm::I2CStatus unexpectedStatus(uint8_t status)
+    {
+        switch (status)
+        {
+        case TW_MT_SLA_NACK:
+        case TW_MR_SLA_NACK:
+            return mm::I2CStatus::AddressNack;
+        case TW_MT_DATA_NACK:
+            return mm::I2CStatus::DataNack;
+        case TW_MT_ARB_LOST:
+            return mm::I2CStatus::ArbitrationLost;
+        default:
+            return mm::I2CStatus::BusError;
+        }
+    }
+
+    /**
+     * @brief Makes a transaction current and resets the phase bookkeeping.
+     */
+    void beginTransaction(mm::I2CTransaction &transaction)
+    {
+        async_state.current = &transaction;
+        async_state.index = 0;
+        async_state.reading = transaction.tx_length == 0 && transaction.rx_length != 0;
+    }
+
+    /**
+     * @brief Sends START for the given transaction on an idle bus.
+     *
+     * The caller makes sure no STOP is pending, otherwise the START is not issued.
+     */
+    void startTransaction(mm::I2CTransaction &transaction)
+    {
+        beginTransaction(transaction);
+        TWCR = TWCR_ASYNC_START;
+    }
+
+    /**
+     * @brief Ends the current transaction, starts the next queued one and runs the callback.
+     *
+     * When another transaction is waiting, STOP and START are requested with one TWCR
+     * write, so the hardware issues the next START as soon as the STOP is on the bus.
+     */
+    void finishTransaction(mm::I2CStatus status, bool send_stop)
+    {
+        mm::I2CTransaction *transaction = async_state.current;
+        mm::I2CTransaction *next;
+        uint8_t stop = send_stop ? (1 << TWSTO) : 0;
+
+        if (async_state.queue.pop(next))
+        {
+            beginTransaction(*next);
+            TWCR = TWCR_ASYNC_START | stop;
+        }
+        else
+        {
+            async_state.current = nullptr;
+            TWCR = (1 << TWINT) | (1 << TWEN) | stop;
+        }
+
+        transaction->status = status;
+        if (transaction->callback)
+        {
+            transaction->callback(*transaction);
+        }
+    }
+
+    /**
+     * @brief Requests the next data byte, acknowledging all but the last one.
+     */
+    void requestByte(const mm::I2CTransaction &transaction)
+    {
+        TWCR = (uint8_t)(async_state.index + 1) < transaction.rx_length ? TWCR_ASYNC_ACK : TWCR_ASYNC;
+    }
+
+    /**
+     * @brief Moves from the write phase to the read phase or ends the transaction.
+     */
+    void endWritePhase(const mm::I2CTransaction &transaction)
+    {
+        if (transaction.rx_length != 0)
+        {
+            async_state.reading = true;
+            async_state.index = 0;
+            TWCR = TWCR_ASYNC_START;
+        }
+        else
+        {
+            finishTransaction(mm::I2CStatus::Ok, true);
+        }
+    }
+}
+
+void (*volatile mm::twi::slaveInterrupt)() = nullptr;
+
+ISR(TWI_vect)
+{
+    mm::I2CTransaction *transaction = async_state.current;
+    async_state.progress = async_state.progress + 1;
+    if (!transaction)
+    {
+        if (mm::twi::slaveInterrupt)
+        {
+            mm::twi::slaveInterrupt();
+            return;
+        }
+
+        TWCR = (1 << TWINT) | (1 << TWEN);
+        return;
+    }
+
+    switch (TW_STATUS)
+    {
+    case TW_START:
+    case TW_REP_START:
+        TWDR = (transaction->address << 1) | (async_state.reading ? TW_READ : TW_WRITE);
+        TWCR = TWCR_ASYNC;
         break;
-    case 4:
-        TWSR = 0x1;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+        if (async_state.index < transaction->tx_length)
+        {
+            TWDR = transaction->tx_data[async_state.index++];
+            TWCR = TWCR_ASYNC;
+        }
+        else
+        {
+            endWritePhase(*transaction);
+        }
         break;
-    case 16:
-        TWSR = 0x2;
+
+    case TW_MT_DATA_NACK:
+        // A slave may refuse the last byte; anything earlier is an error
+        if (async_state.index < transaction->tx_length)
+        {
+            finishTransaction(mm::I2CStatus::DataNack, true);
+        }
+        else
+        {
+            endWritePhase(*transaction);
+        }
         break;
-    case 64:
-        TWSR = 0x3;
+
+    case TW_MT_SLA_NACK:
+    case TW_MR_SLA_NACK:
+        finishTransaction(mm::I2CStatus::AddressNack, true);
         break;
+
+    case TW_MT_ARB_LOST:
+        finishTransaction(mm::I2CStatus::ArbitrationLost, false);
+        break;
+
+    case TW_MR_SLA_ACK:
+        requestByte(*transaction);
+        break;
+
+    case TW_MR_DATA_ACK:
+        transaction->rx_data[async_state.index++] = TWDR;
+        requestByte(*transaction);
+        break;
+
+    case TW_MR_DATA_NACK:
+        transaction->rx_data[async_state.index++] = TWDR;
+        finishTransaction(mm::I2CStatus::Ok, true);
+        break;
+
     default:
-        TWSR = 0x00;
+        finishTransaction(mm::I2CStatus::BusError, true);
         break;
     }
-    TWSR = 0x00;
-    TWBR = BITRATE(TWSR);
+}
+
+void mm::I2C::init()
+{
+    TWSR = clock.twps;
+    TWBR = clock.twbr;
     TWCR = (1 << TWEN);
 }
 
-void mm::I2C::start()
+mm::I2CStatus mm::I2C::start()
 {
+    // An interrupt-driven transaction reports completion while its STOP is still on the bus
+    if (!waitForStop())
+    {
+        return I2CStatus::Timeout;
+    }
+
     TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (!waitForInterruptFlag())
+    {
+        return I2CStatus::Timeout;
+    }
+
+    uint8_t status = TW_STATUS;
+    if (status == TW_START || status == TW_REP_START)
+    {
+        return I2CStatus::Ok;
+    }
+    return unexpectedStatus(status);
 }
 
-void mm::I2C::stop()
+mm::I2CStatus mm::I2C::stop()
 {
     TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
-    while (TWCR & (1 << TWSTO))
-        ;
+    return waitForStop() ? I2CStatus::Ok : I2CStatus::Timeout;
 }
 
-void mm::I2C::write(uint8_t data)
+mm::I2CStatus mm::I2C::write(uint8_t data)
 {
     TWDR = data;
     TWCR = (1 << TWINT) | (1 << TWEN);
-    while (!(TWCR & (1 << TWINT)))
-        ;
+    if (!waitForInterruptFlag())
+    {
+        return I2CStatus::Timeout;
+    }
+
+    uint8_t status = TW_STATUS;
+    if (status == TW_MT_SLA_ACK || status == TW_MT_DATA_ACK || status == TW_MR_SLA_ACK)
+    {
+        return I2CStatus::Ok;
+    }
+    return unexpectedStatus(status);
 }
 
-void mm::I2C::write_data(uint8_t slave_address, uint8_t data)
+mm::I2CStatus mm::I2C::write_data(uint8_t slave_address, uint8_t data)
 {
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::write(data);
-    mm::I2C::stop();
+    I2CStatus status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(slave_address << 1);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(data);
+    return end_transfer(status);
 }
 
-void mm::I2C::write_register(uint8_t slave_address, uint8_t reg, uint8_t data)
+mm::I2CStatus mm::I2C::write_register(uint8_t slave_address, uint8_t reg, uint8_t data)
 {
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::write(reg);
-    mm::I2C::write(data);
-    mm::I2C::stop();
+    I2CStatus status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(slave_address << 1);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(reg);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(data);
+    return end_transfer(status);
 }
 
-uint8_t mm::I2C::read(bool ack)
+mm::I2CStatus mm::I2C::read(bool ack, uint8_t &data)
 {
     TWCR = (1 << TWINT) | (ack ? (1 << TWEA) : 0) | (1 << TWEN);
-    while (!(TWCR & (1 << TWINT)))
-        ;
-    return TWDR;
+    if (!waitForInterruptFlag())
+    {
+        return I2CStatus::Timeout;
+    }
+
+    uint8_t status = TW_STATUS;
+    if (status == (ack ? TW_MR_DATA_ACK : TW_MR_DATA_NACK))
+    {
+        data = TWDR;
+        return I2CStatus::Ok;
+    }
+    return unexpectedStatus(status);
+}
+
+mm::I2CStatus mm::I2C::read_data(uint8_t slave_address, uint8_t &data)
+{
+    I2CStatus status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write((slave_address << 1) | 1);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::read(false, data);
+    return end_transfer(status);
 }
 
 uint8_t mm::I2C::read_data(uint8_t slave_address)
 {
-    uint8_t data;
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::start();
-    mm::I2C::write((slave_address << 1) | 1);
-    data = mm::I2C::read(false);
-    mm::I2C::stop();
+    uint8_t data = 0xFF;
+    mm::I2C::read_data(slave_address, data);
     return data;
 }
 
+mm::I2CStatus mm::I2C::read_register(uint8_t slave_address, uint8_t reg, uint8_t &data)
+{
+    return mm::I2C::read_block(slave_address, reg, &data, 1);
+}
+
 uint8_t mm::I2C::read_register(uint8_t slave_address, uint8_t reg)
 {
-    uint8_t data;
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::write(reg);
-    mm::I2C::start();
-    mm::I2C::write((slave_address << 1) | 1);
-    data = mm::I2C::read(false);
-    mm::I2C::stop();
+    uint8_t data = 0xFF;
+    mm::I2C::read_block(slave_address, reg, &data, 1);
     return data;
 }
 
-void mm::I2C::write_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size)
+mm::I2CStatus mm::I2C::write_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size)
 {
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::write(reg);
+    I2CStatus status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(slave_address << 1);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(reg);
 
-    for (uint8_t i = 0; i < size; i++)
+    for (uint8_t i = 0; i < size && status == I2CStatus::Ok; i++)
     {
-        mm::I2C::write(data[i]);
+        status = mm::I2C::write(data[i]);
     }
 
-    mm::I2C::stop();
+    return end_transfer(status);
 }
 
-void mm::I2C::read_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size)
+mm::I2CStatus mm::I2C::read_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size)
 {
-    mm::I2C::start();
-    mm::I2C::write(slave_address << 1);
-    mm::I2C::write(reg);
-    mm::I2C::start();
-    mm::I2C::write((slave_address << 1) | 1);
+    I2CStatus status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(slave_address << 1);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write(reg);
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::start();
+    if (status == I2CStatus::Ok)
+        status = mm::I2C::write((slave_address << 1) | 1);
 
-    for (uint8_t i = 0; i < size - 1; i++)
+    for (uint8_t i = 0; i < size && status == I2CStatus::Ok; i++)
     {
-        data[i] = mm::I2C::read(true);
+        status = mm::I2C::read(i + 1 < size, data[i]);
     }
 
-    data[size - 1] = mm::I2C::read(false);
-    mm::I2C::stop();
-}
\ No newline at end of file
+    return end_transfer(status);
+}
+
+mm::I2CStatus mm::I2C::end_transfer(I2CStatus status)
+{
+    switch (status)
+    {
+    case I2CStatus::Ok:
+    case I2CStatus::AddressNack:
+    case I2CStatus::DataNack:
+        if (mm::I2C::stop() != I2CStatus::Ok)
+        {
+            mm::I2C::recover_bus();
+            if (status == I2CStatus::Ok)
+            {
+                status = I2CStatus::Timeout;
+            }
+        }
+        break;
+
+    case I2CStatus::ArbitrationLost:
+        // Another master owns the bus; just leave it
+        TWCR = (1 << TWINT) | (1 << TWEN);
+        break;
+
+    default:
+        mm::I2C::recover_bus();
+        break;
+    }
+
+    last_status = status;
+    return status;
+}
+
+mm::I2CStatus mm::I2C::recover_bus()
+{
+    uint8_t lines = (1 << I2C_SDA) | (1 << I2C_SCL);
+    uint8_t pullups = I2C_PORT & lines;
+
+    // Hand the pins back to the port; a line is driven low by making it an output
+    TWCR = 0;
+    I2C_DDR &= ~lines;
+    I2C_PORT &= ~lines;
+
+    // Clock out whatever the slave is still trying to send
+    for (uint8_t i = 0; i < 9 && !(I2C_PIN & (1 << I2C_SDA)); i++)
+    {
+        I2C_DDR |= (1 << I2C_SCL);
+        _delay_us(5);
+        I2C_DDR &= ~(1 << I2C_SCL);
+        _delay_us(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    I2C_DDR |= (1 << I2C_SCL);
+    _delay_us(5);
+    I2C_DDR |= (1 << I2C_SDA);
+    _delay_us(5);
+    I2C_DDR &= ~(1 << I2C_SCL);
+    _delay_us(5);
+    I2C_DDR &= ~(1 << I2C_SDA);
+    _delay_us(5);
+
+    bool idle = (I2C_PIN & lines) == lines;
+
+    I2C_PORT |= pullups;
+    mm::I2C::init();
+
+    return idle ? I2CStatus::Ok : I2CStatus::BusError;
+}
+
+bool mm::I2C::submit(I2CTransaction &transaction)
+{
+    bool accepted = true;
+    bool started = true;
+    bool stopping;
+
+    transaction.status = I2CStatus::Pending;
+
+    do
+    {
+        stopping = false;
+
+        // Only the hand-over to the engine runs with interrupts disabled
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (async_state.current)
+            {
+                accepted = async_state.queue.push(&transaction);
+            }
+            else if (TWCR & (1 << TWSTO))
+            {
+                stopping = true;
+            }
+            else
+            {
+                startTransaction(transaction);
+            }
+        }
+
+        // The STOP of the previous transaction is still on the bus; wait for it with
+        // interrupts enabled and try again
+        if (stopping && !waitForStop())
+        {
+            started = false;
+            stopping = false;
+        }
+    } while (stopping);
+
+    // The bus is stuck in STOP; recover it with interrupts enabled and fail the transaction
+    if (!started)
+    {
+        mm::I2C::recover_bus();
+        transaction.status = I2CStatus::Timeout;
+        if (transaction.callback)
+        {
+            transaction.callback(transaction);
+        }
+    }
+
+    return accepted;
+}
+
+bool mm::I2C::isBusy() const
+{
+    return async_state.current != nullptr;
+}
+
+uint8_t mm::I2C::queued() const
+{
+    return async_state.queue.count();
+}
+
+mm::I2CStatus mm::I2C::wait(const I2CTransaction &transaction)
+{
+    uint8_t progress = async_state.progress;
+    uint16_t idle = 0;
+
+    while (!transaction.isDone())
+    {
+        busyWait();
+        if (progress != async_state.progress)
+        {
+            progress = async_state.progress;
+            idle = 0;
+        }
+        else if (++idle > (uint16_t)I2C_TIMEOUT_LOOPS)
+        {
+            abort();
+        }
+    }
+    return transaction.status;
+}
+
+void mm::I2C::abort()
+{
+    I2CTransaction *cancelled[I2C_QUEUE_SIZE + 1];
+    uint8_t count = 0;
+
+    // Detach everything from the engine before touching the bus
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TWCR = (1 << TWEN);
+        if (async_state.current)
+        {
+            cancelled[count++] = async_state.current;
+            async_state.current = nullptr;
+        }
+        while (async_state.queue.pop(cancelled[count]))
+        {
+            count++;
+        }
+    }
+
+    mm::I2C::recover_bus();
+
+    // Callbacks may already submit new work on the recovered bus
+    for (uint8_t i = 0; i < count; i++)
+    {
+        cancelled[i]->status = I2CStatus::Timeout;
+        if (cancelled[i]->callback)
+        {
+            cancelled[i]->callback(*cancelled[i]);
+        }
+    }
+}
@@ -14,9 +14,86 @@
 #define I2C_H
 
 #include "CommunicationProtocol.h"
+#include "I2CClock.h"
+
+#ifndef SCL_CLK
+#define SCL_CLK 100000UL ///< SCL frequency used by the default constructor.
+#endif
+
+#ifndef I2C_TIMEOUT_US
+#define I2C_TIMEOUT_US 2000 ///< Longest time a blocking operation waits for the hardware.
+#endif
+
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 8 ///< Number of transactions that can wait behind the one on the bus.
+#endif
 
 namespace mm
 {
+    namespace twi
+    {
+        /**
+         * @brief Handler run by `TWI_vect` when no master transaction is in flight.
+         *
+         * `I2CSlave::init()` installs its event handler here, so the slave engine is only
+         * linked into programs that use it.
+         */
+        extern void (*volatile slaveInterrupt)();
+    }
+
+    /**
+     * @brief Result of an I2C operation.
+     */
+    enum class I2CStatus : uint8_t
+    {
+        Ok,              ///< The operation completed successfully.
+        Pending,         ///< The transaction is queued or in progress.
+        AddressNack,     ///< No device acknowledged the address.
+        DataNack,        ///< The device did not acknowledge a data byte.
+        ArbitrationLost, ///< Another master took over the bus.
+        BusError,        ///< An illegal START or STOP condition was detected.
+        Timeout          ///< The hardware did not respond in time.
+    };
+
+    struct I2CTransaction;
+
+    /**
+     * @brief Function called from the TWI interrupt when a transaction finishes.
+     */
+    typedef void (*I2CCallback)(I2CTransaction &transaction);
+
+    /**
+     * @struct I2CTransaction
+     * @brief Description of one asynchronous I2C master transfer.
+     * 
+     * The engine sends START, the address with the write bit and `tx_length` bytes from
+     * `tx_data`, then, if `rx_length` is not zero, a repeated START, the address with the
+     * read bit and reads `rx_length` bytes into `rx_data`, and finally STOP. Either phase
+     * may be empty; with both empty the transaction only probes the address.
+     * 
+     * The structure and both buffers must stay valid until `status` is no longer
+     * `I2CStatus::Pending`.
+     */
+    struct I2CTransaction
+    {
+        uint8_t address;           ///< 7-bit address of the slave device.
+        const uint8_t *tx_data;    ///< Bytes to write, e.g. a register address.
+        uint8_t tx_length;         ///< Number of bytes to write.
+        uint8_t *rx_data;          ///< Buffer for the bytes read.
+        uint8_t rx_length;         ///< Number of bytes to read.
+        I2CCallback callback;      ///< Completion callback run in interrupt context, or nullptr.
+        void *context;             ///< User data for the callback.
+        volatile I2CStatus status; ///< Result, `I2CStatus::Pending` until the transaction ends.
+
+        /**
+         * @brief Checks whether the transaction has finished, successfully or not.
+         */
+        bool isDone() const
+        {
+            return status != I2CStatus::Pending;
+        }
+    };
+
     /**
      * @class I2C
      * @brief Class for I2C communication protocol.
@@ -27,32 +104,79 @@ namespace mm
      * It supports single byte and block write/read operations as well as the 
      * ability to communicate with I2C slave devices by their address.
      * 
-     * @note The class assumes that the prescaling value is provided or defaults to 1.
+     * Besides the blocking functions, `submit()` runs an `I2CTransaction` from the
+     * `TWI_vect` interrupt, so the program can keep working while the transfer is on the
+     * bus. Transactions submitted while the bus is busy wait in a fixed-size queue and
+     * are started by the interrupt as soon as the previous one ends, so a batch of reads
+     * and writes runs back-to-back. Blocking functions must not be used while
+     * transactions are in flight.
+     * 
+     * Every operation checks the TWI status code and waits at most `I2C_TIMEOUT_US` for
+     * the hardware, so a missing device, a NACK or a stuck bus is reported as an
+     * `I2CStatus` instead of hanging the program.
+     * 
+     * @note The class assumes that the SCL frequency is provided or defaults to `SCL_CLK`
+     *       (100 kHz). Up to 400 kHz Fast Mode is supported.
      */
     class I2C : public CommunicationProtocol
     {
     private:
-        uint8_t prescaling; ///< Prescaling value for the communication speed.
+        I2CClock clock;         ///< TWBR and prescaler for the SCL frequency.
+        I2CStatus last_status;  ///< Result of the last blocking operation.
+
+        /**
+         * @brief Releases the bus after a blocking operation and records its result.
+         * 
+         * Sends STOP when this master still owns the bus and runs the bus recovery after a
+         * timeout or bus error.
+         * 
+         * @param status The result of the operation so far.
+         * @return The final result of the operation.
+         */
+        I2CStatus end_transfer(I2CStatus status);
 
     public:
         /**
-         * @brief Constructs an I2C object with a specified prescaling value.
+         * @brief Constructs an I2C object with a specified SCL frequency.
          * 
-         * Initializes the I2C interface with a specific prescaler value.
+         * The TWBR value and prescaler are chosen by `i2cClock()` for the fastest frequency
+         * that does not exceed the request. With a constant argument the calculation is
+         * folded by the compiler.
          * 
-         * @param prs The prescaling value to set the communication speed(1, 4, 16, 64).
+         * @code
+         * mm::I2C i2c(mm::Hz(400000UL));
+         * @endcode
+         * 
+         * @param scl_frequency The SCL frequency, e.g. `mm::Hz(100000UL)` or `mm::Hz(400000UL)`.
          */
-        I2C(uint32_t prs)
-            : prescaling(prs) {}
+        explicit I2C(Hz scl_frequency)
+            : clock(i2cClock(F_CPU, scl_frequency.value)), last_status(I2CStatus::Ok) {}
+
+        /**
+         * @brief Rejects a plain number as the SCL setting.
+         * 
+         * The argument used to be a TWI prescaler and later a frequency in Hz, so a bare
+         * number is ambiguous; wrap a frequency in `mm::Hz`.
+         */
+        I2C(uint32_t) = delete;
+
+        /**
+         * @brief Constructs an I2C object with precomputed clock registers.
+         * 
+         * @param clock The TWBR value and prescaler to program.
+         */
+        explicit I2C(I2CClock clock)
+            : clock(clock), last_status(I2CStatus::Ok) {}
 
         /**
          * @brief Default constructor for the I2C class.
          * 
-         * Initializes the prescaling value to 1 if no argument is provided.
+         * Initializes the SCL frequency to `SCL_CLK` if no argument is provided.
          */
         I2C()
         {
-            prescaling = 1;
+            clock = i2cClock(F_CPU, SCL_CLK);
+            last_status = I2CStatus::Ok;
         }
 
         /**
@@ -62,28 +186,48 @@ namespace mm
          */
         void init() override;
 
+        /**
+         * @brief Returns the SCL frequency programmed by `init()`.
+         * 
+         * @return The frequency in Hz, ignoring the rise time of the bus.
+         */
+        uint32_t frequency() const
+        {
+            return i2cFrequency(F_CPU, clock);
+        }
+
         /**
          * @brief Starts an I2C communication session.
          * 
          * Initiates the I2C start condition to signal the beginning of communication.
+         * A STOP still being sent, e.g. by a transaction that `wait()` has just reported
+         * as done, is waited for first.
+         * 
+         * @return `I2CStatus::Ok` once START or repeated START is on the bus,
+         *         `I2CStatus::ArbitrationLost`, `I2CStatus::BusError` or `I2CStatus::Timeout`.
          */
-        void start();
+        I2CStatus start();
 
         /**
          * @brief Stops an ongoing I2C communication session.
          * 
          * Sends the I2C stop condition to end communication with the current device.
+         * 
+         * @return `I2CStatus::Ok` or `I2CStatus::Timeout` if the STOP never completed.
          */
-        void stop();
+        I2CStatus stop();
 
         /**
          * @brief Sends a single byte of data over I2C.
          * 
-         * This function sends a single byte of data on the I2C bus.
+         * This function sends a single byte of data on the I2C bus. The byte following
+         * START is treated as the address byte.
          * 
          * @param data The byte of data to transmit.
+         * @return `I2CStatus::Ok` if the byte was acknowledged, `I2CStatus::AddressNack` or
+         *         `I2CStatus::DataNack` if not, or another error status.
          */
-        void write(uint8_t data);
+        I2CStatus write(uint8_t data);
 
         /**
          * @brief Writes a byte of data to a specified I2C slave device.
@@ -92,8 +236,9 @@ namespace mm
          * 
          * @param slave_address The address of the I2C slave device.
          * @param data The byte of data to write to the slave.
+         * @return The result of the operation.
          */
-        void write_data(uint8_t slave_address, uint8_t data);
+        I2CStatus write_data(uint8_t slave_address, uint8_t data);
 
         /**
          * @brief Writes data to a specific register of an I2C slave device.
@@ -103,8 +248,9 @@ namespace mm
          * @param slave_address The address of the I2C slave device.
          * @param reg The register address where data should be written.
          * @param data The byte of data to write.
+         * @return The result of the operation.
          */
-        void write_register(uint8_t slave_address, uint8_t reg, uint8_t data);
+        I2CStatus write_register(uint8_t slave_address, uint8_t reg, uint8_t data);
 
         /**
          * @brief Reads a byte of data from the I2C bus.
@@ -112,9 +258,10 @@ namespace mm
          * This function reads a byte of data from the I2C bus with an optional acknowledgment.
          * 
          * @param ack Boolean value to control whether to send an ACK (true) or NACK (false) after reading.
-         * @return The byte of data read from the bus.
+         * @param data Reference that receives the byte read from the bus.
+         * @return The result of the operation.
          */
-        uint8_t read(bool ack);
+        I2CStatus read(bool ack, uint8_t &data);
 
         /**
          * @brief Reads a byte of data from an I2C slave device.
@@ -122,7 +269,18 @@ namespace mm
          * This function reads a byte of data from the specified I2C slave device.
          * 
          * @param slave_address The address of the I2C slave device.
-         * @return The byte of data read from the slave device.
+         * @param data Reference that receives the byte read from the slave device.
+         * @return The result of the operation.
+         */
+        I2CStatus read_data(uint8_t slave_address, uint8_t &data);
+
+        /**
+         * @brief Reads a byte of data from an I2C slave device.
+         * 
+         * Convenience overload; the result is available from `lastStatus()`.
+         * 
+         * @param slave_address The address of the I2C slave device.
+         * @return The byte of data read from the slave device, 0xFF on failure.
          */
         uint8_t read_data(uint8_t slave_address);
 
@@ -133,9 +291,21 @@ namespace mm
          * 
          * @param slave_address The address of the I2C slave device.
          * @param reg The register address to read from.
-         * @return The byte of data read from the register.
+         * @param data Reference that receives the byte read from the register.
+         * @return The result of the operation.
          */
-        uint8_t read_register(uint8_t slave_Address, uint8_t reg);
+        I2CStatus read_register(uint8_t slave_address, uint8_t reg, uint8_t &data);
+
+        /**
+         * @brief Reads a byte of data from a specific register of an I2C slave device.
+         * 
+         * Convenience overload; the result is available from `lastStatus()`.
+         * 
+         * @param slave_address The address of the I2C slave device.
+         * @param reg The register address to read from.
+         * @return The byte of data read from the register, 0xFF on failure.
+         */
+        uint8_t read_register(uint8_t slave_address, uint8_t reg);
 
         /**
          * @brief Writes a block of data to an I2C slave device.
@@ -147,8 +317,9 @@ namespace mm
          * @param reg The starting register address.
          * @param data Pointer to the data block to write.
          * @param size The number of bytes to write.
+         * @return The result of the operation.
          */
-        void write_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size);
+        I2CStatus write_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size);
 
         /**
          * @brief Reads a block of data from an I2C slave device.
@@ -160,8 +331,86 @@ namespace mm
          * @param reg The starting register address.
          * @param data Pointer to a buffer to store the received data.
          * @param size The number of bytes to read.
+         * @return The result of the operation.
+         */
+        I2CStatus read_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size);
+
+        /**
+         * @brief Returns the result of the last blocking operation.
+         */
+        I2CStatus lastStatus() const
+        {
+            return last_status;
+        }
+
+        /**
+         * @brief Frees a bus that is held by a slave.
+         * 
+         * A slave that was interrupted in the middle of a read (e.g. by a reset of the
+         * master) may keep SDA low forever. The TWI module is switched off, up to nine
+         * clock pulses are generated on SCL until the slave releases SDA, and a STOP
+         * condition is sent by hand before the module is enabled again. Blocking
+         * operations run this automatically after a timeout or bus error.
+         * 
+         * @return `I2CStatus::Ok` if both lines are high afterwards, `I2CStatus::BusError` otherwise.
+         */
+        I2CStatus recover_bus();
+
+        /**
+         * @brief Starts or queues an interrupt-driven transaction.
+         * 
+         * The function returns immediately. If the bus is idle the transaction starts at
+         * once, otherwise it is queued behind the ones already submitted. The result is
+         * reported through `transaction.status` and the optional callback, which may
+         * submit further transactions. Global interrupts must be enabled.
+         * 
+         * Interrupts are only disabled while the transaction is handed to the engine; a STOP
+         * of an earlier transfer that is still on the bus is waited for with interrupts
+         * enabled. If it does not complete within `I2C_TIMEOUT_US`, the bus is recovered with `recover_bus()` and the transaction finishes at once with
+         * `I2CStatus::Timeout`.
+         * 
+         * @code
+         * uint8_t reg = 0xF7;
+         * uint8_t data[8];
+         * mm::I2CTransaction t = {0x76, &reg, 1, data, sizeof(data), nullptr, nullptr};
+         * i2c.submit(t);
+         * // ... other work ...
+         * if (i2c.wait(t) == mm::I2CStatus::Ok) { ... }
+         * @endcode
+         * 
+         * @param transaction The transaction to run. It must not already be pending.
+         * @return True if the transaction was started or queued, false if the queue is full.
+         */
+        bool submit(I2CTransaction &transaction);
+
+        /**
+         * @brief Checks whether an interrupt-driven transaction is in flight.
+         */
+        bool isBusy() const;
+
+        /**
+         * @brief Returns the number of transactions waiting behind the current one.
+         */
+        uint8_t queued() const;
+
+        /**
+         * @brief Waits until a submitted transaction has finished.
+         * 
+         * If the engine makes no progress for `I2C_TIMEOUT_US`, all pending transactions
+         * are aborted with `abort()`.
+         * 
+         * @param transaction The transaction to wait for.
+         * @return The final status of the transaction.
+         */
+        I2CStatus wait(const I2CTransaction &transaction);
+
+        /**
+         * @brief Cancels the transaction in flight and all queued ones.
+         * 
+         * Each cancelled transaction finishes with `I2CStatus::Timeout` and its callback
+         * runs; then the bus is recovered with `recover_bus()`.
          */
-        void read_block(uint8_t slave_address, uint8_t reg, uint8_t *data, uint8_t size);
+        void abort();
     };
 }
 #endif // I2C_H
\ No newline at end of file
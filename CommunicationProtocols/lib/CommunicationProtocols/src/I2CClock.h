@@ -0,0 +1,124 @@
+/**
+ * @file I2CClock.h
+ * @brief SCL frequency calculation for the AVR TWI module.
+ *
+ * This file defines `Hz`, `I2CClock` and the `constexpr` helpers that choose the TWBR value and
+ * the TWPS prescaler for a requested bus frequency. When the frequency is a constant the
+ * whole calculation is done by the compiler.
+ */
+
+#ifndef I2C_CLOCK_H
+#define I2C_CLOCK_H
+
+#include <stdint.h>
+
+namespace mm
+{
+    /**
+     * @struct Hz
+     * @brief A frequency in hertz.
+     *
+     * The constructor is explicit, so a plain number is never taken for a frequency by
+     * accident, e.g. an old TWI prescaler value passed to the `I2C` constructor.
+     */
+    struct Hz
+    {
+        uint32_t value; ///< The frequency in Hz.
+
+        constexpr explicit Hz(uint32_t value) : value(value) {}
+    };
+
+    /**
+     * @struct I2CClock
+     * @brief Register values that produce an SCL frequency.
+     *
+     * SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS)
+     */
+    struct I2CClock
+    {
+        uint8_t twbr; ///< Value for the TWBR bit rate register.
+        uint8_t twps; ///< Prescaler bits for TWSR (0..3 for 1, 4, 16, 64).
+    };
+
+    namespace twi
+    {
+        /**
+         * @brief Returns the prescaler factor selected by the TWPS bits.
+         */
+        constexpr uint32_t prescaler(uint8_t twps)
+        {
+            return 1UL << (2 * twps);
+        }
+
+        /**
+         * @brief Returns the smallest CPU clock divider that does not exceed the target.
+         */
+        constexpr uint32_t divider(uint32_t f_cpu, uint32_t scl)
+        {
+            return (f_cpu + scl - 1) / scl;
+        }
+
+        /**
+         * @brief Returns the smallest TWBR value whose frequency does not exceed the target.
+         */
+        constexpr uint32_t bitRate(uint32_t f_cpu, uint32_t scl, uint8_t twps)
+        {
+            return divider(f_cpu, scl) <= 16
+                       ? 0
+                       : (divider(f_cpu, scl) - 16 + 2 * prescaler(twps) - 1) / (2 * prescaler(twps));
+        }
+
+        /**
+         * @brief Returns the smallest prescaler for which TWBR fits in eight bits.
+         *
+         * The smallest prescaler gives the finest frequency steps.
+         */
+        constexpr uint8_t selectPrescaler(uint32_t f_cpu, uint32_t scl, uint8_t twps)
+        {
+            return twps >= 3 || bitRate(f_cpu, scl, twps) <= 255 ? twps : selectPrescaler(f_cpu, scl, twps + 1);
+        }
+
+        /**
+         * @brief Limits a TWBR value to the range of the register.
+         */
+        constexpr uint8_t clamp(uint32_t twbr)
+        {
+            return twbr > 255 ? 255 : (uint8_t)twbr;
+        }
+    }
+
+    /**
+     * @brief Chooses the register values for the fastest SCL frequency not above the target.
+     *
+     * Staying at or below the target keeps the bus within the limits of the slowest
+     * device, e.g. 100 kHz for Standard Mode or 400 kHz for Fast Mode.
+     *
+     * @code
+     * constexpr mm::I2CClock fast = mm::i2cClock(F_CPU, 400000UL);
+     * static_assert(mm::i2cFrequency(F_CPU, fast) == 400000UL, "no exact 400 kHz");
+     * @endcode
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param scl The requested SCL frequency in Hz.
+     * @return The TWBR value and prescaler bits to program.
+     */
+    constexpr I2CClock i2cClock(uint32_t f_cpu, uint32_t scl)
+    {
+        return I2CClock{twi::clamp(twi::bitRate(f_cpu, scl, twi::selectPrescaler(f_cpu, scl, 0))),
+                        twi::selectPrescaler(f_cpu, scl, 0)};
+    }
+
+    /**
+     * @brief Returns the SCL frequency produced by a register setting.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param clock The register setting.
+     * @return The SCL frequency in Hz, ignoring rise time on the bus.
+     */
+    constexpr uint32_t i2cFrequency(uint32_t f_cpu, I2CClock clock)
+    {
+        return f_cpu / (16 + 2 * clock.twbr * twi::prescaler(clock.twps));
+    }
+}
+
+#endif // I2C_CLOCK_H
@@ -0,0 +1,160 @@
+#include "I2CSlave.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+
+// TWCR values used by the slave engine
+#define TWCR_SLAVE_ACK ((1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA))
+
+namespace
+{
+    /**
+     * @brief State of the interrupt-driven slave engine.
+     */
+    struct SlaveState
+    {
+        uint8_t *registers;                               ///< Register map.
+        uint8_t size;                                     ///< Number of registers.
+        uint8_t pointer;                                  ///< Register accessed by the next data byte.
+        bool pointer_pending;                             ///< The next written byte sets the pointer.
+        mm::I2CSlaveWriteHook volatile write_hook;        ///< Write filter, or nullptr.
+        mm::I2CSlaveGeneralCallHook volatile general_hook; ///< General call handler, or nullptr.
+    };
+
+    SlaveState slave_state;
+
+    /**
+     * @brief Stores a byte written by the master and advances the pointer.
+     */
+    void storeRegister(uint8_t value)
+    {
+        uint8_t reg = slave_state.pointer;
+        if (reg >= slave_state.size)
+        {
+            return;
+        }
+
+        mm::I2CSlaveWriteHook hook = slave_state.write_hook;
+        if (!hook || hook(reg, value))
+        {
+            slave_state.registers[reg] = value;
+        }
+        slave_state.pointer = reg + 1;
+    }
+
+    /**
+     * @brief Handles one TWI event addressed to the slave.
+     */
+    void slaveEvent()
+    {
+        uint8_t data;
+
+        switch (TW_STATUS)
+        {
+        case TW_SR_SLA_ACK:
+        case TW_SR_ARB_LOST_SLA_ACK:
+            TWCR = TWCR_SLAVE_ACK;
+            slave_state.pointer_pending = true;
+            break;
+
+        case TW_SR_DATA_ACK:
+        case TW_SR_DATA_NACK:
+            data = TWDR;
+            TWCR = TWCR_SLAVE_ACK;
+            if (slave_state.pointer_pending)
+            {
+                slave_state.pointer = data;
+                slave_state.pointer_pending = false;
+            }
+            else
+            {
+                storeRegister(data);
+            }
+            break;
+
+        case TW_SR_GCALL_DATA_ACK:
+        case TW_SR_GCALL_DATA_NACK:
+            data = TWDR;
+            TWCR = TWCR_SLAVE_ACK;
+            if (slave_state.general_hook)
+            {
+                slave_state.general_hook(data);
+            }
+            break;
+
+        case TW_ST_SLA_ACK:
+        case TW_ST_ARB_LOST_SLA_ACK:
+        case TW_ST_DATA_ACK:
+            if (slave_state.pointer < slave_state.size)
+            {
+                TWDR = slave_state.registers[slave_state.pointer++];
+            }
+            else
+            {
+                TWDR = I2C_SLAVE_IDLE_BYTE;
+            }
+            TWCR = TWCR_SLAVE_ACK;
+            break;
+
+        case TW_BUS_ERROR:
+            // Release the lines and return to the not addressed state
+            TWCR = TWCR_SLAVE_ACK | (1 << TWSTO);
+            break;
+
+        default:
+            // General call address, STOP, end of a read: wait for the next address
+            TWCR = TWCR_SLAVE_ACK;
+            break;
+        }
+    }
+}
+
+void mm::I2CSlave::init()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        slave_state.registers = registers;
+        slave_state.size = size;
+        slave_state.pointer = 0;
+        slave_state.pointer_pending = false;
+        twi::slaveInterrupt = slaveEvent;
+
+        TWAR = (address << 1) | (general_call ? (1 << TWGCE) : 0);
+#if defined(TWAMR)
+        TWAMR = address_mask << 1;
+#endif
+        TWCR = TWCR_SLAVE_ACK;
+    }
+}
+
+void mm::I2CSlave::setWriteHook(I2CSlaveWriteHook hook)
+{
+    slave_state.write_hook = hook;
+}
+
+void mm::I2CSlave::setGeneralCallHook(I2CSlaveGeneralCallHook hook)
+{
+    slave_state.general_hook = hook;
+}
+
+void mm::I2CSlave::update(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t i = 0; i < len && (uint8_t)(reg + i) < size; i++)
+        {
+            registers[reg + i] = data[i];
+        }
+    }
+}
+
+void mm::I2CSlave::end()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TWCR = 0;
+        TWAR = 0;
+        twi::slaveInterrupt = nullptr;
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file I2CSlave.h
+ * @brief Header file for the I2C slave (TWI target) with register-map emulation.
+ *
+ * This file defines the `I2CSlave` class, which lets the AVR answer an I2C master like a
+ * sensor: the master writes a register pointer, then reads or writes consecutive
+ * registers of a byte array owned by the application.
+ *
+ * @note This class inherits from the `CommunicationProtocol` class.
+ *
+ * @see CommunicationProtocol
+ */
+
+#ifndef I2C_SLAVE_H
+#define I2C_SLAVE_H
+
+#include "CommunicationProtocol.h"
+#include "I2C.h"
+
+#ifndef I2C_SLAVE_IDLE_BYTE
+#define I2C_SLAVE_IDLE_BYTE 0xFF ///< Byte sent when the master reads past the register map.
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Function called from the TWI interrupt before a register is written by the master.
+     *
+     * @param reg The register about to be written.
+     * @param value The value sent by the master.
+     * @return True to store the value, false to keep the register unchanged (read-only).
+     */
+    typedef bool (*I2CSlaveWriteHook)(uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Function called from the TWI interrupt for each byte of a general call.
+     *
+     * @param data The byte sent to address 0, e.g. 0x06 for a reset request.
+     */
+    typedef void (*I2CSlaveGeneralCallHook)(uint8_t data);
+
+    /**
+     * @class I2CSlave
+     * @brief Interrupt-driven I2C slave exposing a register map.
+     *
+     * The protocol follows common I2C sensors:
+     * - Write: address, register pointer, then data bytes stored at the pointer, which
+     *   increments after every byte.
+     * - Read: address (usually after a write of the pointer and a repeated START), then
+     *   bytes from the pointer, which increments after every byte.
+     *
+     * Bytes outside the map are ignored on writes and read as `I2C_SLAVE_IDLE_BYTE`.
+     * Every TWI interrupt writes TWCR before doing anything else, so SCL is only stretched
+     * for the few cycles it takes to enter the interrupt.
+     *
+     * @code
+     * uint8_t registers[8];
+     * mm::I2CSlave slave(0x42, registers, sizeof(registers));
+     * slave.init();
+     * sei();
+     * int16_t temperature = ...;
+     * slave.update(0, (uint8_t *)&temperature, sizeof(temperature));
+     * @endcode
+     *
+     * @note A node is either an I2C master (`I2C`) or a slave; both share `TWI_vect`.
+     */
+    class I2CSlave : public CommunicationProtocol
+    {
+    private:
+        uint8_t address;      ///< 7-bit slave address.
+        uint8_t address_mask; ///< Address bits ignored when matching (TWAMR).
+        bool general_call;    ///< Whether the slave answers the general call address.
+        uint8_t *registers;   ///< Register map shared with the application.
+        uint8_t size;         ///< Number of registers in the map.
+
+    public:
+        /**
+         * @brief Constructs an I2C slave with a register map.
+         *
+         * @param address The 7-bit address to answer.
+         * @param registers The register map; it must stay valid while the slave runs.
+         * @param size Number of registers in the map.
+         * @param general_call Whether to answer the general call address 0.
+         * @param address_mask Address bits to ignore, so one slave answers several addresses.
+         *                     Ignored on devices without TWAMR.
+         */
+        I2CSlave(uint8_t address, uint8_t *registers, uint8_t size, bool general_call = false,
+                 uint8_t address_mask = 0)
+            : address(address), address_mask(address_mask), general_call(general_call),
+              registers(registers), size(size) {}
+
+        /**
+         * @brief Initializes the TWI module as a slave and enables its interrupt.
+         *
+         * Global interrupts must be enabled.
+         */
+        void init() override;
+
+        /**
+         * @brief Installs or removes the hook called before a register is written.
+         *
+         * @param hook The hook, or nullptr to make all registers writable.
+         */
+        void setWriteHook(I2CSlaveWriteHook hook);
+
+        /**
+         * @brief Installs or removes the hook called for general call data.
+         *
+         * @param hook The hook, or nullptr to ignore general call data.
+         */
+        void setGeneralCallHook(I2CSlaveGeneralCallHook hook);
+
+        /**
+         * @brief Copies values into the register map with interrupts disabled.
+         *
+         * The master cannot see half of a multi-byte value that is being updated, unless
+         * it is already in the middle of reading it.
+         *
+         * @param reg The first register to update.
+         * @param data The new values.
+         * @param len Number of registers to update.
+         */
+        void update(uint8_t reg, const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Disables the slave and releases `TWI_vect`.
+         */
+        void end();
+    };
+}
+#endif // I2C_SLAVE_H
@@ -0,0 +1,14 @@
+#include "Print.h"
+
+const uint32_t mm::print::powers_of_10[10] PROGMEM = {
+    1UL,
+    10UL,
+    100UL,
+    1000UL,
+    10000UL,
+    100000UL,
+    1000000UL,
+    10000000UL,
+    100000000UL,
+    1000000000UL,
+};
@@ -0,0 +1,312 @@
+/**
+ * @file Print.h
+ * @brief Allocation-free formatted output for byte streams.
+ *
+ * This file defines the `Print` mixin, which formats integers, fixed-point values,
+ * hexadecimal numbers and strings directly into the transmit path of the class that
+ * inherits it. No intermediate buffers, no floating point and no printf are used:
+ * decimal digits come from repeated subtraction of powers of ten, which on AVR is much
+ * cheaper than 32-bit division.
+ */
+
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+/**
+ * @brief Places a string literal in flash and wraps it for `Print`.
+ *
+ * @code
+ * uart << MM_F("Temperature: ") << mm::fixed(2315, 2) << MM_F(" C\n");
+ * @endcode
+ */
+#define MM_F(s) (mm::FlashString{PSTR(s)})
+
+namespace mm
+{
+    /**
+     * @brief A string stored in program memory.
+     */
+    struct FlashString
+    {
+        const char *str; ///< Address of the string in flash.
+    };
+
+    /**
+     * @brief A decimal fixed-point value, e.g. 2315 with 2 decimals for 23.15.
+     */
+    struct FixedPoint
+    {
+        int32_t value;    ///< Value scaled by 10^decimals.
+        uint8_t decimals; ///< Number of digits after the decimal point (0..9).
+    };
+
+    /**
+     * @brief An unsigned value printed in hexadecimal with a fixed number of digits.
+     */
+    struct HexNumber
+    {
+        uint32_t value; ///< The value to print.
+        uint8_t digits; ///< Number of digits, including leading zeros (1..8).
+    };
+
+    /**
+     * @brief Wraps a scaled integer for fixed-point output.
+     *
+     * @param value Value scaled by 10^decimals.
+     * @param decimals Number of digits after the decimal point.
+     */
+    inline FixedPoint fixed(int32_t value, uint8_t decimals)
+    {
+        return FixedPoint{value, decimals};
+    }
+
+    /**
+     * @brief Wraps a value for hexadecimal output.
+     *
+     * @param value The value to print.
+     * @param digits Number of digits, including leading zeros; more than 8 print as 8.
+     */
+    inline HexNumber hex(uint32_t value, uint8_t digits = 2)
+    {
+        return HexNumber{value, digits > 8 ? (uint8_t)8 : digits};
+    }
+
+    namespace print
+    {
+        extern const uint32_t powers_of_10[10] PROGMEM; ///< 10^0 .. 10^9.
+    }
+
+    /**
+     * @class Print
+     * @brief Formatting functions mixed into a byte stream.
+     *
+     * `Derived` must provide `transmitByte(uint8_t)` and `transmitString(const char *)`.
+     * Every `print()` overload is also available as `operator<<`, so output can be chained:
+     *
+     * @code
+     * uart << "Pressure: " << mm::fixed(101325, 2) << " hPa, raw 0x" << mm::hex(raw, 6) << '\n';
+     * @endcode
+     *
+     * @tparam Derived The class inheriting `Print`.
+     */
+    template <typename Derived>
+    class Print
+    {
+    private:
+        /**
+         * @brief Returns the stream the output goes to.
+         */
+        Derived &out()
+        {
+            return *static_cast<Derived *>(this);
+        }
+
+        /**
+         * @brief Writes the decimal digits of a value.
+         *
+         * @param value The value to print.
+         * @param min_digits Minimum number of digits, padded with leading zeros.
+         * @param decimals Number of digits after the decimal point, 0 for none.
+         */
+        void printDigits(uint32_t value, uint8_t min_digits, uint8_t decimals)
+        {
+            bool started = false;
+            for (int8_t i = 9; i >= 0; i--)
+            {
+                uint32_t power = pgm_read_dword(&print::powers_of_10[i]);
+                char digit = '0';
+                while (value >= power)
+                {
+                    value -= power;
+                    digit++;
+                }
+
+                started = started || digit != '0' || i < (int8_t)min_digits;
+                if (started)
+                {
+                    out().transmitByte(digit);
+                    if (decimals && i == (int8_t)decimals)
+                    {
+                        out().transmitByte('.');
+                    }
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Writes a single character.
+         */
+        void print(char c)
+        {
+            out().transmitByte(c);
+        }
+
+        /**
+         * @brief Writes a null-terminated string from RAM.
+         */
+        void print(const char *str)
+        {
+            out().transmitString(str);
+        }
+
+        /**
+         * @brief Writes a null-terminated string from flash.
+         */
+        void print(FlashString str)
+        {
+            const char *p = str.str;
+            char c;
+            while ((c = pgm_read_byte(p++)) != '\0')
+            {
+                out().transmitByte(c);
+            }
+        }
+
+        /**
+         * @brief Writes "true" or "false".
+         *
+         * Without this overload a `bool` would be promoted and printed as a number.
+         */
+        void print(bool value)
+        {
+            print(value ? "true" : "false");
+        }
+
+        /**
+         * @brief Writes an unsigned integer in decimal.
+         */
+        void print(uint32_t value)
+        {
+            printDigits(value, 1, 0);
+        }
+
+        /**
+         * @brief Writes a signed integer in decimal.
+         */
+        void print(int32_t value)
+        {
+            if (value < 0)
+            {
+                out().transmitByte('-');
+                printDigits(-(uint32_t)value, 1, 0);
+            }
+            else
+            {
+                printDigits(value, 1, 0);
+            }
+        }
+
+        /**
+         * @brief Writes an unsigned integer in decimal.
+         */
+        void print(uint16_t value)
+        {
+            print((uint32_t)value);
+        }
+
+        /**
+         * @brief Writes a signed integer in decimal.
+         */
+        void print(int16_t value)
+        {
+            print((int32_t)value);
+        }
+
+        /**
+         * @brief Writes a byte value in decimal.
+         */
+        void print(uint8_t value)
+        {
+            print((uint32_t)value);
+        }
+
+        /**
+         * @brief Writes a fixed-point value, e.g. "-3.05" for {-305, 2}.
+         */
+        void print(FixedPoint number)
+        {
+            uint32_t magnitude = number.value;
+            if (number.value < 0)
+            {
+                out().transmitByte('-');
+                magnitude = -(uint32_t)number.value;
+            }
+            printDigits(magnitude, number.decimals + 1, number.decimals);
+        }
+
+        /**
+         * @brief Writes a value in upper-case hexadecimal without a prefix.
+         *
+         * At most 8 digits are written, all a 32-bit value has.
+         */
+        void print(HexNumber number)
+        {
+            int8_t digits = number.digits > 8 ? 8 : number.digits;
+            for (int8_t i = digits - 1; i >= 0; i--)
+            {
+                uint8_t nibble = (number.value >> (4 * i)) & 0x0F;
+                out().transmitByte(nibble < 10 ? '0' + nibble : 'A' - 10 + nibble);
+            }
+        }
+
+        /**
+         * @brief Writes a fixed-point value.
+         *
+         * @param value Value scaled by 10^decimals.
+         * @param decimals Number of digits after the decimal point.
+         */
+        void printFixed(int32_t value, uint8_t decimals)
+        {
+            print(fixed(value, decimals));
+        }
+
+        /**
+         * @brief Writes a value in hexadecimal.
+         *
+         * @param value The value to print.
+         * @param digits Number of digits, including leading zeros (1..8).
+         */
+        void printHex(uint32_t value, uint8_t digits)
+        {
+            print(hex(value, digits));
+        }
+
+        /**
+         * @brief Writes raw bytes, including zeros, e.g. a binary frame.
+         *
+         * @param data The bytes to write.
+         * @param len Number of bytes.
+         */
+        void write(const uint8_t *data, uint8_t len)
+        {
+            for (uint8_t i = 0; i < len; i++)
+            {
+                out().transmitByte(data[i]);
+            }
+        }
+
+        /**
+         * @brief Writes a line break.
+         */
+        void println()
+        {
+            out().transmitByte('\n');
+        }
+
+        /**
+         * @brief Writes any value accepted by `print()` and returns the stream for chaining.
+         */
+        template <typename T>
+        Derived &operator<<(T value)
+        {
+            print(value);
+            return out();
+        }
+    };
+}
+
+#endif // PRINT_H
@@ -0,0 +1,44 @@
+/**
+ * @file Register.h
+ * @brief Type of an 8-bit I/O register.
+ *
+ * Drivers that keep a reference or a pointer to a register, e.g. the chip select PORT of
+ * an `SPIDevice`, use `mm::Register` instead of `volatile uint8_t`. On the AVR the two
+ * are the same type, so the generated code does not change. When the library is built
+ * against the host simulator (lib/AvrSim), `<avr/io.h>` defines `MM_HOST_SIMULATION` and
+ * every register is an object whose reads and writes drive simulated peripherals.
+ */
+
+#ifndef REGISTER_H
+#define REGISTER_H
+
+#include <stdint.h>
+#include <avr/io.h>
+
+namespace mm
+{
+#if defined(MM_HOST_SIMULATION)
+    typedef sim::Register Register;
+
+    /**
+     * @brief Marks one iteration of a loop that waits for an interrupt to change memory.
+     *
+     * The simulator advances time here, so the interrupt can happen.
+     */
+    inline void busyWait()
+    {
+        sim::idle();
+    }
+#else
+    typedef volatile uint8_t Register;
+
+    /**
+     * @brief Marks one iteration of a loop that waits for an interrupt to change memory.
+     *
+     * Compiles to nothing on the AVR.
+     */
+    inline void busyWait() {}
+#endif
+}
+
+#endif // REGISTER_H
@@ -0,0 +1,186 @@
+/**
+ * @file RingBuffer.h
+ * @brief Header file for the fixed-size ring buffer used by the interrupt-driven drivers.
+ *
+ * This file defines the `RingBuffer` class template, a single-producer/single-consumer
+ * FIFO that is safe to share between the main program and one interrupt service routine
+ * without disabling interrupts.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+
+namespace mm
+{
+    /**
+     * @class RingBuffer
+     * @brief Lock-free single-producer/single-consumer ring buffer.
+     *
+     * The producer only ever writes `head` and the consumer only ever writes `tail`.
+     * Both indices are single bytes, so every update is atomic on AVR and no critical
+     * section is needed as long as there is exactly one producer and one consumer.
+     *
+     * The indices run freely and are masked on access, which keeps every slot usable
+     * and makes `count()` a single subtraction.
+     *
+     * @tparam T Type of the stored elements.
+     * @tparam Size Capacity of the buffer. Must be a power of two and at most 128.
+     */
+    template <typename T, uint8_t Size>
+    class RingBuffer
+    {
+        static_assert(Size != 0 && (Size & (Size - 1)) == 0, "RingBuffer size must be a power of two");
+        static_assert(Size <= 128, "RingBuffer size must not exceed 128");
+
+    private:
+        static constexpr uint8_t mask = Size - 1; ///< Mask applied to the free-running indices.
+
+        T buffer[Size];         ///< Storage for the elements.
+        volatile uint8_t head;  ///< Index of the next free slot, written only by the producer.
+        volatile uint8_t tail;  ///< Index of the oldest element, written only by the consumer.
+
+    public:
+        /**
+         * @brief Constructs an empty ring buffer.
+         *
+         * The constructor is `constexpr`, so a buffer with static storage is zeroed with
+         * the rest of .bss instead of by startup code.
+         */
+        constexpr RingBuffer()
+            : buffer(), head(0), tail(0) {}
+
+        /**
+         * @brief Appends an element to the buffer (producer side).
+         *
+         * @param value The element to append.
+         * @return True if the element was stored, false if the buffer was full.
+         */
+        bool push(T value)
+        {
+            uint8_t h = head;
+            if ((uint8_t)(h - tail) == Size)
+            {
+                return false;
+            }
+            buffer[h & mask] = value;
+            head = h + 1;
+            return true;
+        }
+
+        /**
+         * @brief Removes the oldest element from the buffer (consumer side).
+         *
+         * @param value Reference that receives the removed element.
+         * @return True if an element was removed, false if the buffer was empty.
+         */
+        bool pop(T &value)
+        {
+            uint8_t t = tail;
+            if (t == head)
+            {
+                return false;
+            }
+            value = buffer[t & mask];
+            tail = t + 1;
+            return true;
+        }
+
+        /**
+         * @brief Returns the oldest element without removing it (consumer side).
+         *
+         * @param value Reference that receives the element.
+         * @return True if an element was available, false if the buffer was empty.
+         */
+        bool peek(T &value) const
+        {
+            uint8_t t = tail;
+            if (t == head)
+            {
+                return false;
+            }
+            value = buffer[t & mask];
+            return true;
+        }
+
+        /**
+         * @brief Drops the oldest element (consumer side).
+         *
+         * When called from the producer side the caller must make sure the consumer
+         * cannot run at the same time, e.g. by disabling its interrupt.
+         */
+        void discard()
+        {
+            if (tail != head)
+            {
+                tail = tail + 1;
+            }
+        }
+
+        /**
+         * @brief Takes back the newest elements (producer side).
+         *
+         * The caller must make sure the consumer has not read them and cannot run at the
+         * same time, e.g. by calling it from the interrupt that produced them.
+         *
+         * @param n Number of elements to remove, at most `count()`.
+         */
+        void unpush(uint8_t n)
+        {
+            head = head - n;
+        }
+
+        /**
+         * @brief Returns the number of stored elements.
+         */
+        uint8_t count() const
+        {
+            return (uint8_t)(head - tail);
+        }
+
+        /**
+         * @brief Returns the number of free slots.
+         */
+        uint8_t space() const
+        {
+            return Size - count();
+        }
+
+        /**
+         * @brief Checks whether the buffer is empty.
+         */
+        bool isEmpty() const
+        {
+            return head == tail;
+        }
+
+        /**
+         * @brief Checks whether the buffer is full.
+         */
+        bool isFull() const
+        {
+            return count() == Size;
+        }
+
+        /**
+         * @brief Removes all elements.
+         *
+         * Must not race with either side; call it with the consumer interrupt disabled.
+         */
+        void clear()
+        {
+            tail = head;
+        }
+
+        /**
+         * @brief Returns the capacity of the buffer.
+         */
+        static constexpr uint8_t capacity()
+        {
+            return Size;
+        }
+    };
+}
+
+#endif // RING_BUFFER_H
@@ -5,16 +5,16 @@ void mm::SPI::init()
 {
     if (isMaster)
     {
+        PORTB |= (1 << ss_pin);
         DDRB |= (1 << mosi_pin) | (1 << sck_pin) | (1 << ss_pin);
         DDRB &= ~(1 << miso_pin);
-        SPCR = (1 << SPE) | (1 << MSTR);
     }
     else
     {
         DDRB |= (1 << miso_pin);
         DDRB &= ~((1 << mosi_pin) | (1 << sck_pin) | (1 << ss_pin));
-        SPCR = (1 << SPE);
     }
+    applySettings();
 }
 
 void mm::SPI::write(uint8_t data)
@@ -39,20 +39,46 @@ uint8_t mm::SPI::recive()
     return SPDR;
 }
 
+void mm::SPI::transfer(const uint8_t *tx, uint8_t *rx, uint8_t len)
+{
+    device().transfer(tx, rx, len);
+}
+
 void mm::SPI::writeRegister(uint8_t reg, uint8_t value)
 {
-    reg &= 0x7F;
-    PORTB &= ~(1 << ss_pin);
-    SPI::write(reg);
-    SPI::write(value);
-    PORTB |= (1 << ss_pin);
+    device().writeRegister(reg, value);
 }
 
 uint8_t mm::SPI::readRegister(uint8_t reg)
 {
-    reg |= 0x80;
-    PORTB &= ~(1 << ss_pin);
-    SPI::write(reg);
-    return SPI::read();
-    PORTB |= (1 << ss_pin);
+    return device().readRegister(reg);
+}
+
+void mm::SPI::readBlock(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    device().readBlock(reg, buf, len);
+}
+
+void mm::SPI::writeBlock(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    device().writeBlock(reg, data, len);
+}
+
+bool mm::SPI::submit(SPITransfer &transfer)
+{
+    if (!isMaster)
+    {
+        return false;
+    }
+    return device().submit(transfer);
+}
+
+bool mm::SPI::isBusy() const
+{
+    return bus.isBusy();
+}
+
+void mm::SPI::wait(const SPITransfer &transfer)
+{
+    bus.wait(transfer);
 }
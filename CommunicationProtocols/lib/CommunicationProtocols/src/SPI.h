@@ -15,6 +15,7 @@
 #define SPI_H
 
 #include "CommunicationProtocol.h"
+#include "SPIBus.h"
 
 namespace mm
 {
@@ -27,6 +28,12 @@ namespace mm
      * 
      * It supports both master and slave configurations for SPI communication.
      * 
+     * Besides the blocking functions, `submit()` runs an `SPITransfer` from the
+     * `SPI_STC_vect` interrupt, so the CPU can do other work while the bytes are shifted.
+     * 
+     * In master mode the class is a single `SPIDevice` on an `SPIBus` with its chip
+     * select on PORTB; use those classes directly to share the bus between devices.
+     * 
      * @note The class assumes that the default pins are used for the SPI bus in master mode.
      */
     class SPI : public CommunicationProtocol
@@ -37,6 +44,25 @@ namespace mm
         uint8_t sck_pin;  ///< Pin for Serial Clock (SCK) signal.
         uint8_t ss_pin;   ///< Pin for Slave Select (SS) signal.
         bool isMaster;    ///< Flag to indicate whether the device is in master mode.
+        SPISettings settings; ///< Clock, mode and bit order of the device.
+        SPIBus bus;           ///< Hardware used in master mode.
+
+        /**
+         * @brief Programs the clock, mode and bit order of this device into the hardware.
+         */
+        void applySettings()
+        {
+            SPCR = (1 << SPE) | (isMaster ? (1 << MSTR) : 0) | settings.spcr;
+            SPSR = settings.spsr;
+        }
+
+        /**
+         * @brief Returns a handle for the slave on `ss_pin` with the current settings.
+         */
+        SPIDevice device()
+        {
+            return SPIDevice(bus, DDRB, PORTB, ss_pin, settings);
+        }
 
     public:
         /**
@@ -50,14 +76,30 @@ namespace mm
          * @param sck The pin number for the SCK signal.
          * @param ss The pin number for the SS signal.
          * @param master Boolean value to set the device as master (true) or slave (false).
+         * @param settings Clock, mode and bit order, e.g. from `spiSettings()`. Only the
+         *                 mode and bit order apply in slave mode.
+         */
+        SPI(uint8_t mosi, uint8_t miso, uint8_t sck, uint8_t ss, bool master,
+            SPISettings settings = spiSettings(F_CPU, SPI_CLK))
+            : mosi_pin(mosi), miso_pin(miso), sck_pin(sck), ss_pin(ss), isMaster(master), settings(settings) {}
+
+        /**
+         * @brief Constructs a master on the default pins with the given settings.
+         * 
+         * @code
+         * mm::SPI spi(mm::spiSettings(F_CPU, 8000000UL, mm::SPIMode::Mode3));
+         * @endcode
+         * 
+         * @param settings Clock, mode and bit order of the device.
          */
-        SPI(uint8_t mosi, uint8_t miso, uint8_t sck, uint8_t ss, bool master)
-            : mosi_pin(mosi), miso_pin(miso), sck_pin(sck), ss_pin(ss), isMaster(master) {}
+        explicit SPI(SPISettings settings)
+            : mosi_pin(PB3), miso_pin(PB4), sck_pin(PB5), ss_pin(PB2), isMaster(true), settings(settings) {}
 
         /**
          * @brief Default constructor for the SPI class.
          * 
-         * Initializes the SPI pins with default values and sets the device as master.
+         * Initializes the SPI pins with default values and sets the device as master,
+         * clocked at `SPI_CLK` in mode 0, MSB first.
          */
         SPI()
         {
@@ -66,6 +108,7 @@ namespace mm
             sck_pin = PB5;
             ss_pin = PB2;
             isMaster = true;
+            settings = spiSettings(F_CPU, SPI_CLK);
         }
 
         /**
@@ -76,6 +119,26 @@ namespace mm
          */
         void init() override;
 
+        /**
+         * @brief Replaces the clock, mode and bit order used by the next transaction.
+         * 
+         * @param settings The new settings.
+         */
+        void setSettings(SPISettings settings)
+        {
+            this->settings = settings;
+        }
+
+        /**
+         * @brief Returns the SCK frequency used in master mode.
+         * 
+         * @return The frequency in Hz.
+         */
+        uint32_t frequency() const
+        {
+            return spiFrequency(F_CPU, settings);
+        }
+
         /**
          * @brief Sends a single byte of data via SPI and returns the received byte.
          * 
@@ -124,6 +187,86 @@ namespace mm
          * @return The byte value read from the register.
          */
         uint8_t readRegister(uint8_t reg);
+
+        /**
+         * @brief Exchanges a sequence of bytes with an SPI device in one burst.
+         * 
+         * The slave select line stays asserted for the whole transfer. Each byte is written
+         * to `SPDR` as soon as the previous one has been shifted out, so the bus runs without
+         * gaps between bytes.
+         * 
+         * @param tx Bytes to send, or `nullptr` to send 0xFF (read only).
+         * @param rx Buffer for the received bytes, or `nullptr` to discard them (write only).
+         *           It may be the same buffer as `tx`.
+         * @param len Number of bytes to exchange.
+         */
+        void transfer(const uint8_t *tx, uint8_t *rx, uint8_t len);
+
+        /**
+         * @brief Reads consecutive registers of an SPI device in one burst.
+         * 
+         * Sends the register address with the read bit (0x80) set, then reads `len` bytes
+         * while the device increments the address.
+         * 
+         * @param reg The first register address to read from.
+         * @param buf Buffer for the register values.
+         * @param len Number of registers to read.
+         */
+        void readBlock(uint8_t reg, uint8_t *buf, uint8_t len);
+
+        /**
+         * @brief Writes a block of data to an SPI device in one burst.
+         * 
+         * Sends the register address with the read bit cleared, followed by `len` bytes.
+         * 
+         * @note How the bytes after the first one are interpreted is device specific. The
+         *       BME280, for example, expects register address and value pairs.
+         * 
+         * @param reg The register address to write to.
+         * @param data The bytes to write.
+         * @param len Number of bytes to write.
+         */
+        void writeBlock(uint8_t reg, const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Starts an interrupt-driven transfer.
+         * 
+         * The function asserts the slave select line, sends the first byte and returns.
+         * Each following byte is exchanged from the `SPI_STC_vect` interrupt; after the
+         * last one the line is deasserted, `transfer.done` is set and the optional
+         * callback runs. The callback may submit the next transfer. Global interrupts
+         * must be enabled, and the blocking functions must not be used until the
+         * transfer has finished.
+         * 
+         * @note Every byte costs one interrupt, so at the fastest clock dividers a
+         *       blocking `transfer()` finishes sooner. The gain is the CPU time that is
+         *       free between the bytes at slower clocks or for longer buffers.
+         * 
+         * @code
+         * uint8_t cmd[9] = {0xF7 | 0x80};
+         * mm::SPITransfer t = {cmd, cmd, sizeof(cmd), nullptr, nullptr};
+         * spi.submit(t);
+         * // ... other work ...
+         * spi.wait(t); // cmd[1..8] holds the registers
+         * @endcode
+         * 
+         * @param transfer The transfer to run.
+         * @return True if the transfer was started, false if another one is in flight or
+         *         the interface is not a master.
+         */
+        bool submit(SPITransfer &transfer);
+
+        /**
+         * @brief Checks whether an interrupt-driven transfer is in flight.
+         */
+        bool isBusy() const;
+
+        /**
+         * @brief Waits until a submitted transfer has finished.
+         * 
+         * @param transfer The transfer to wait for.
+         */
+        void wait(const SPITransfer &transfer);
     };
 }
 #endif // SPI_H
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "SPIBus.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+namespace
+{
+    /**
+     * @brief State of the interrupt-driven master engine.
+     */
+    struct AsyncState
+    {
+        mm::SPITransfer *volatile current; ///< Transfer on the bus, nullptr when idle.
+        uint8_t index;                     ///< Index of the byte being shifted.
+        mm::Register *cs_port;             ///< PORT register of the selected device.
+        uint8_t cs_mask;                   ///< Chip select bit of the selected device.
+    };
+
+    AsyncState async_state;
+
+    /**
+     * @brief Marks a transfer as finished and runs its callback.
+     */
+    void completeTransfer(mm::SPITransfer &transfer)
+    {
+        transfer.done = true;
+        if (transfer.callback)
+        {
+            transfer.callback(transfer);
+        }
+    }
+}
+
+void (*volatile mm::spi::slaveInterrupt)() = nullptr;
+
+ISR(SPI_STC_vect)
+{
+    mm::SPITransfer *transfer = async_state.current;
+    if (!transfer)
+    {
+        if (mm::spi::slaveInterrupt)
+        {
+            mm::spi::slaveInterrupt();
+        }
+        return;
+    }
+
+    uint8_t in = SPDR;
+    uint8_t index = async_state.index + 1;
+
+    if (index < transfer->length)
+    {
+        SPDR = transfer->tx_data ? transfer->tx_data[index] : 0xFF;
+    }
+    else
+    {
+        SPCR &= ~(1 << SPIE);
+        *async_state.cs_port |= async_state.cs_mask;
+        async_state.current = nullptr;
+    }
+
+    if (transfer->rx_data)
+    {
+        transfer->rx_data[index - 1] = in;
+    }
+    async_state.index = index;
+
+    if (!async_state.current)
+    {
+        completeTransfer(*transfer);
+    }
+}
+
+void mm::SPIBus::init()
+{
+    SPI_PORT |= (1 << SPI_SS);
+    SPI_DDR |= (1 << SPI_MOSI) | (1 << SPI_SCK) | (1 << SPI_SS);
+    SPI_DDR &= ~(1 << SPI_MISO);
+    SPCR = (1 << SPE) | (1 << MSTR);
+}
+
+void mm::SPIBus::exchange(const uint8_t *tx, uint8_t *rx, uint8_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    SPDR = tx ? tx[0] : 0xFF;
+    for (uint8_t i = 1; i < len; i++)
+    {
+        uint8_t next = tx ? tx[i] : 0xFF;
+        while (!(SPSR & (1 << SPIF)))
+            ;
+        // Start the next byte first, the received one stays in the read buffer
+        uint8_t in = SPDR;
+        SPDR = next;
+        if (rx)
+        {
+            rx[i - 1] = in;
+        }
+    }
+
+    while (!(SPSR & (1 << SPIF)))
+        ;
+    uint8_t in = SPDR;
+    if (rx)
+    {
+        rx[len - 1] = in;
+    }
+}
+
+uint8_t mm::SPIBus::exchangeByte(uint8_t data)
+{
+    SPDR = data;
+    while (!(SPSR & (1 << SPIF)))
+        ;
+    return SPDR;
+}
+
+bool mm::SPIBus::submit(SPITransfer &transfer, const SPIDevice &device)
+{
+    bool accepted = true;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (async_state.current)
+        {
+            accepted = false;
+        }
+        else if (transfer.length == 0)
+        {
+            completeTransfer(transfer);
+        }
+        else
+        {
+            transfer.done = false;
+            async_state.current = &transfer;
+            async_state.index = 0;
+            async_state.cs_port = device.cs_port;
+            async_state.cs_mask = device.cs_mask;
+
+            device.select();
+            SPDR = transfer.tx_data ? transfer.tx_data[0] : 0xFF;
+            SPCR |= (1 << SPIE);
+        }
+    }
+
+    return accepted;
+}
+
+bool mm::SPIBus::isBusy() const
+{
+    return async_state.current != nullptr;
+}
+
+void mm::SPIBus::wait(const SPITransfer &transfer)
+{
+    while (!transfer.isDone())
+    {
+        busyWait();
+    }
+}
+
+void mm::SPIDevice::init()
+{
+    *cs_port |= cs_mask;
+    *cs_ddr |= cs_mask;
+}
+
+void mm::SPIDevice::transfer(const uint8_t *tx, uint8_t *rx, uint8_t len)
+{
+    select();
+    bus.exchange(tx, rx, len);
+    deselect();
+}
+
+void mm::SPIDevice::writeRegister(uint8_t reg, uint8_t value)
+{
+    select();
+    bus.exchangeByte((reg & format.address_mask) | format.write_flag);
+    bus.exchangeByte(value);
+    deselect();
+}
+
+uint8_t mm::SPIDevice::readRegister(uint8_t reg)
+{
+    select();
+    bus.exchangeByte((reg & format.address_mask) | format.read_flag);
+    uint8_t value = bus.exchangeByte(0xFF);
+    deselect();
+    return value;
+}
+
+void mm::SPIDevice::readBlock(uint8_t reg, uint8_t *buf, uint8_t len)
+{
+    select();
+    bus.exchangeByte((reg & format.address_mask) | format.read_flag);
+    bus.exchange(nullptr, buf, len);
+    deselect();
+}
+
+void mm::SPIDevice::writeBlock(uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    select();
+    bus.exchangeByte((reg & format.address_mask) | format.write_flag);
+    bus.exchange(data, nullptr, len);
+    deselect();
+}
@@ -0,0 +1,329 @@
+/**
+ * @file SPIBus.h
+ * @brief Header file for the shared SPI master bus and the devices attached to it.
+ *
+ * This file defines the `SPIBus` class, which owns the SPI hardware in master mode, and
+ * the `SPIDevice` class, a lightweight handle that carries the chip select pin, clock
+ * settings and register conventions of one device on that bus.
+ *
+ * @note `SPIBus` inherits from the `CommunicationProtocol` class.
+ *
+ * @see CommunicationProtocol
+ */
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include "CommunicationProtocol.h"
+#include "Register.h"
+#include "SPISettings.h"
+
+#ifndef SPI_CLK
+#define SPI_CLK (F_CPU / 4) ///< SCK frequency used when no settings are given.
+#endif
+
+// Hardware SPI pins
+#ifndef SPI_DDR
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega32U4__)
+#define SPI_DDR DDRB
+#define SPI_PORT PORTB
+#define SPI_PIN PINB
+#define SPI_SS PB0
+#define SPI_SCK PB1
+#define SPI_MOSI PB2
+#define SPI_MISO PB3
+#else
+#define SPI_DDR DDRB
+#define SPI_PORT PORTB
+#define SPI_PIN PINB
+#define SPI_SS PB2
+#define SPI_MOSI PB3
+#define SPI_MISO PB4
+#define SPI_SCK PB5
+#endif
+#endif
+
+namespace mm
+{
+    struct SPITransfer;
+    class SPIDevice;
+
+    namespace spi
+    {
+        /**
+         * @brief Handler run by `SPI_STC_vect` when no master transfer is in flight.
+         *
+         * `SPISlave::init()` installs its byte handler here, so the slave engine is only
+         * linked into programs that use it.
+         */
+        extern void (*volatile slaveInterrupt)();
+    }
+
+    /**
+     * @brief Function called from the SPI interrupt when a transfer finishes.
+     */
+    typedef void (*SPICallback)(SPITransfer &transfer);
+
+    /**
+     * @struct SPITransfer
+     * @brief Description of one interrupt-driven SPI master transfer.
+     *
+     * The engine asserts the slave select line, exchanges `length` bytes and deasserts
+     * the line again. The structure and both buffers must stay valid until `done` is set.
+     */
+    struct SPITransfer
+    {
+        const uint8_t *tx_data; ///< Bytes to send, or nullptr to send 0xFF.
+        uint8_t *rx_data;       ///< Buffer for the received bytes, or nullptr to discard them.
+        uint8_t length;         ///< Number of bytes to exchange.
+        SPICallback callback;   ///< Completion callback run in interrupt context, or nullptr.
+        void *context;          ///< User data for the callback.
+        volatile bool done;     ///< Set when the transfer has finished.
+
+        /**
+         * @brief Checks whether the transfer has finished.
+         */
+        bool isDone() const
+        {
+            return done;
+        }
+    };
+
+    /**
+     * @struct SPIRegisterFormat
+     * @brief How a device encodes the direction in the register address byte.
+     *
+     * The address byte is `(reg & address_mask) | read_flag` for reads and
+     * `(reg & address_mask) | write_flag` for writes.
+     */
+    struct SPIRegisterFormat
+    {
+        uint8_t address_mask; ///< Bits of the register address sent to the device.
+        uint8_t read_flag;    ///< Bits set in the address byte of a read.
+        uint8_t write_flag;   ///< Bits set in the address byte of a write.
+    };
+
+    /**
+     * @class SPIBus
+     * @brief The SPI hardware in master mode, shared by any number of `SPIDevice` handles.
+     *
+     * The bus only moves bytes; chip select, clock settings and register conventions
+     * belong to the devices. There is one SPI module, so all `SPIBus` objects drive the
+     * same hardware.
+     */
+    class SPIBus : public CommunicationProtocol
+    {
+    public:
+        /**
+         * @brief Initializes the SPI hardware as a master.
+         *
+         * MOSI and SCK become outputs and MISO an input. The hardware SS pin is driven
+         * high as an output, otherwise a low level on it would switch the module to
+         * slave mode; it may be used as the chip select of one device.
+         */
+        void init() override;
+
+        /**
+         * @brief Exchanges a sequence of bytes without touching any chip select line.
+         *
+         * Each byte is written to `SPDR` as soon as the previous one has been shifted
+         * out, so the bus runs without gaps between bytes.
+         *
+         * @param tx Bytes to send, or `nullptr` to send 0xFF.
+         * @param rx Buffer for the received bytes, or `nullptr` to discard them.
+         *           It may be the same buffer as `tx`.
+         * @param len Number of bytes to exchange.
+         */
+        void exchange(const uint8_t *tx, uint8_t *rx, uint8_t len);
+
+        /**
+         * @brief Exchanges a single byte.
+         *
+         * @param data The byte to send.
+         * @return The byte received at the same time.
+         */
+        uint8_t exchangeByte(uint8_t data);
+
+        /**
+         * @brief Starts an interrupt-driven transfer with a device.
+         *
+         * The function selects the device, sends the first byte and returns. Each
+         * following byte is exchanged from the `SPI_STC_vect` interrupt; after the last
+         * one the chip select is deasserted, `transfer.done` is set and the optional
+         * callback runs. The callback may submit the next transfer. Global interrupts
+         * must be enabled, and no blocking transfer may be started until this one has
+         * finished.
+         *
+         * @note Every byte costs one interrupt, so at the fastest clock dividers a
+         *       blocking transfer finishes sooner. The gain is the CPU time that is free
+         *       between the bytes at slower clocks or for longer buffers.
+         *
+         * @param transfer The transfer to run.
+         * @param device The device to select for the transfer.
+         * @return True if the transfer was started, false if another one is in flight.
+         */
+        bool submit(SPITransfer &transfer, const SPIDevice &device);
+
+        /**
+         * @brief Checks whether an interrupt-driven transfer is in flight.
+         */
+        bool isBusy() const;
+
+        /**
+         * @brief Waits until a submitted transfer has finished.
+         *
+         * @param transfer The transfer to wait for.
+         */
+        void wait(const SPITransfer &transfer);
+    };
+
+    /**
+     * @class SPIDevice
+     * @brief Handle for one device on an `SPIBus`.
+     *
+     * Each device has its own chip select pin on any port, its own clock, mode and bit
+     * order and its own register address convention. Selecting a device writes SPCR and
+     * SPSR and clears the chip select bit, so switching between devices costs nothing
+     * more than that.
+     *
+     * @code
+     * mm::SPIBus bus;
+     * mm::SPIDevice bme280(bus, DDRB, PORTB, PB2, mm::spiSettings(F_CPU, 10000000UL));
+     * mm::SPIDevice flash(bus, DDRD, PORTD, PD7, mm::spiSettings(F_CPU, 8000000UL, mm::SPIMode::Mode3));
+     * @endcode
+     */
+    class SPIDevice
+    {
+    private:
+        SPIBus &bus;                 ///< Bus the device is attached to.
+        Register *cs_ddr;            ///< DDR register of the chip select pin.
+        Register *cs_port;           ///< PORT register of the chip select pin.
+        uint8_t cs_mask;             ///< Bit of the chip select pin in `cs_port`.
+        SPISettings settings;        ///< Clock, mode and bit order of the device.
+        SPIRegisterFormat format;    ///< Register address convention of the device.
+
+        friend class SPIBus;
+
+    public:
+        /**
+         * @brief Constructs a handle for a device on the given bus.
+         *
+         * @param bus The bus the device is attached to.
+         * @param cs_ddr The DDR register of the chip select pin, e.g. `DDRD`.
+         * @param cs_port The PORT register of the chip select pin, e.g. `PORTD`.
+         * @param cs_pin The pin number of the chip select within the port.
+         * @param settings Clock, mode and bit order, e.g. from `spiSettings()`.
+         * @param format Register address convention; by default bit 7 marks a read.
+         */
+        SPIDevice(SPIBus &bus, Register &cs_ddr, Register &cs_port, uint8_t cs_pin,
+                  SPISettings settings = spiSettings(F_CPU, SPI_CLK),
+                  SPIRegisterFormat format = SPIRegisterFormat{0x7F, 0x80, 0x00})
+            : bus(bus), cs_ddr(&cs_ddr), cs_port(&cs_port), cs_mask(1 << cs_pin), settings(settings), format(format) {}
+
+        /**
+         * @brief Makes the chip select pin an output and deasserts it.
+         */
+        void init();
+
+        /**
+         * @brief Applies the settings of the device and asserts its chip select.
+         *
+         * The settings are written before the line goes low, so the clock already idles
+         * at the polarity of this device.
+         */
+        void select() const
+        {
+            SPCR = (1 << SPE) | (1 << MSTR) | settings.spcr;
+            SPSR = settings.spsr;
+            *cs_port &= ~cs_mask;
+        }
+
+        /**
+         * @brief Deasserts the chip select of the device.
+         */
+        void deselect() const
+        {
+            *cs_port |= cs_mask;
+        }
+
+        /**
+         * @brief Replaces the clock, mode and bit order used by the next transaction.
+         *
+         * @param settings The new settings.
+         */
+        void setSettings(SPISettings settings)
+        {
+            this->settings = settings;
+        }
+
+        /**
+         * @brief Returns the SCK frequency used for this device.
+         *
+         * @return The frequency in Hz.
+         */
+        uint32_t frequency() const
+        {
+            return spiFrequency(F_CPU, settings);
+        }
+
+        /**
+         * @brief Exchanges a sequence of bytes with the device in one burst.
+         *
+         * @param tx Bytes to send, or `nullptr` to send 0xFF (read only).
+         * @param rx Buffer for the received bytes, or `nullptr` to discard them (write only).
+         * @param len Number of bytes to exchange.
+         */
+        void transfer(const uint8_t *tx, uint8_t *rx, uint8_t len);
+
+        /**
+         * @brief Writes a value to a register of the device.
+         *
+         * @param reg The register address to write to.
+         * @param value The byte value to write to the register.
+         */
+        void writeRegister(uint8_t reg, uint8_t value);
+
+        /**
+         * @brief Reads a value from a register of the device.
+         *
+         * @param reg The register address to read from.
+         * @return The byte value read from the register.
+         */
+        uint8_t readRegister(uint8_t reg);
+
+        /**
+         * @brief Reads consecutive registers of the device in one burst.
+         *
+         * @param reg The first register address to read from.
+         * @param buf Buffer for the register values.
+         * @param len Number of registers to read.
+         */
+        void readBlock(uint8_t reg, uint8_t *buf, uint8_t len);
+
+        /**
+         * @brief Writes a block of data to the device in one burst.
+         *
+         * @note How the bytes after the first one are interpreted is device specific. The
+         *       BME280, for example, expects register address and value pairs.
+         *
+         * @param reg The register address to write to.
+         * @param data The bytes to write.
+         * @param len Number of bytes to write.
+         */
+        void writeBlock(uint8_t reg, const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Starts an interrupt-driven transfer with the device.
+         *
+         * @see SPIBus::submit
+         *
+         * @param transfer The transfer to run.
+         * @return True if the transfer was started, false if another one is in flight.
+         */
+        bool submit(SPITransfer &transfer)
+        {
+            return bus.submit(transfer, *this);
+        }
+    };
+}
+#endif // SPI_BUS_H
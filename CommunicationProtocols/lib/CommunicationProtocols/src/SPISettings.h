@@ -0,0 +1,137 @@
+/**
+ * @file SPISettings.h
+ * @brief Clock, mode and bit order configuration for the AVR SPI module.
+ *
+ * This file defines `SPISettings` and the `constexpr` helpers that turn a target clock
+ * frequency, an SPI mode and a bit order into SPCR and SPSR bits. When the arguments are
+ * constants the whole calculation is done by the compiler.
+ */
+
+#ifndef SPI_SETTINGS_H
+#define SPI_SETTINGS_H
+
+#include <stdint.h>
+#include <avr/io.h>
+
+namespace mm
+{
+    /**
+     * @brief Clock polarity and phase of an SPI device.
+     */
+    enum class SPIMode : uint8_t
+    {
+        Mode0, ///< CPOL = 0, CPHA = 0.
+        Mode1, ///< CPOL = 0, CPHA = 1.
+        Mode2, ///< CPOL = 1, CPHA = 0.
+        Mode3  ///< CPOL = 1, CPHA = 1.
+    };
+
+    /**
+     * @brief Order in which the bits of a byte are shifted.
+     */
+    enum class SPIBitOrder : uint8_t
+    {
+        MsbFirst, ///< Most significant bit first.
+        LsbFirst  ///< Least significant bit first.
+    };
+
+    /**
+     * @struct SPISettings
+     * @brief Register bits that configure the SPI module for one device.
+     *
+     * SCK = F_CPU / 2^shift, where the shift (1..7) is encoded in SPR1:0 and SPI2X.
+     */
+    struct SPISettings
+    {
+        uint8_t spcr; ///< DORD, CPOL, CPHA, SPR1 and SPR0 bits for SPCR.
+        uint8_t spsr; ///< SPI2X bit for SPSR.
+    };
+
+    namespace spi
+    {
+        /**
+         * @brief Returns the smallest clock shift whose frequency does not exceed the target.
+         */
+        constexpr uint8_t clockShift(uint32_t f_cpu, uint32_t clock, uint8_t shift)
+        {
+            return shift >= 7 || ((f_cpu + (1UL << shift) - 1) >> shift) <= clock
+                       ? shift
+                       : clockShift(f_cpu, clock, shift + 1);
+        }
+
+        /**
+         * @brief Returns the SPR1:0 bits of a clock shift.
+         *
+         * F_CPU / 128 has no double-speed variant, every other shift is SPR with or
+         * without SPI2X.
+         */
+        constexpr uint8_t rateBits(uint8_t shift)
+        {
+            return shift >= 7 ? 3 : (shift - 1) / 2;
+        }
+
+        /**
+         * @brief Returns whether a clock shift needs the SPI2X bit.
+         */
+        constexpr bool doubleSpeed(uint8_t shift)
+        {
+            return shift < 7 && (shift & 1);
+        }
+
+        /**
+         * @brief Returns the SPCR bits of an SPI mode.
+         */
+        constexpr uint8_t modeBits(SPIMode mode)
+        {
+            return (((uint8_t)mode & 2) ? (1 << CPOL) : 0) | (((uint8_t)mode & 1) ? (1 << CPHA) : 0);
+        }
+
+        /**
+         * @brief Returns the clock shift encoded in a setting.
+         */
+        constexpr uint8_t shiftOf(SPISettings settings)
+        {
+            return (settings.spcr & 3) == 3 && !(settings.spsr & (1 << SPI2X))
+                       ? 7
+                       : 2 * (settings.spcr & 3) + 2 - ((settings.spsr & (1 << SPI2X)) ? 1 : 0);
+        }
+    }
+
+    /**
+     * @brief Chooses the register bits for the fastest SCK not above the target.
+     *
+     * Targets below F_CPU / 128 get the slowest clock the module can produce.
+     *
+     * @code
+     * constexpr mm::SPISettings bme280 = mm::spiSettings(F_CPU, 8000000UL, mm::SPIMode::Mode0);
+     * static_assert(mm::spiFrequency(F_CPU, bme280) == 8000000UL, "BME280 below 8 MHz");
+     * @endcode
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param clock The highest SCK frequency the device supports, in Hz.
+     * @param mode The clock polarity and phase of the device.
+     * @param order The bit order of the device.
+     * @return The SPCR and SPSR bits to program.
+     */
+    constexpr SPISettings spiSettings(uint32_t f_cpu, uint32_t clock, SPIMode mode = SPIMode::Mode0,
+                                      SPIBitOrder order = SPIBitOrder::MsbFirst)
+    {
+        return SPISettings{(uint8_t)((order == SPIBitOrder::LsbFirst ? (1 << DORD) : 0) | spi::modeBits(mode) |
+                                     (spi::rateBits(spi::clockShift(f_cpu, clock, 1)) << SPR0)),
+                           (uint8_t)(spi::doubleSpeed(spi::clockShift(f_cpu, clock, 1)) ? (1 << SPI2X) : 0)};
+    }
+
+    /**
+     * @brief Returns the SCK frequency produced by a setting.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param settings The register setting.
+     * @return The SCK frequency in Hz.
+     */
+    constexpr uint32_t spiFrequency(uint32_t f_cpu, SPISettings settings)
+    {
+        return f_cpu >> spi::shiftOf(settings);
+    }
+}
+
+#endif // SPI_SETTINGS_H
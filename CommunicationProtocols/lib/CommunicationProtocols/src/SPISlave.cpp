@@ -0,0 +1,209 @@
+#include "SPISlave.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "RingBuffer.h"
+
+namespace
+{
+    /**
+     * @brief State of the interrupt-driven slave engine.
+     */
+    struct SlaveState
+    {
+        mm::RingBuffer<uint8_t, SPI_SLAVE_RX_BUFFER_SIZE> rx;         ///< Bytes received from the master.
+        mm::RingBuffer<uint8_t, SPI_SLAVE_TX_BUFFER_SIZE> tx;         ///< Bytes waiting to be sent.
+        mm::RingBuffer<uint8_t, SPI_SLAVE_FRAME_QUEUE_SIZE> frames;   ///< Lengths of completed frames.
+        mm::SPISlaveResponder volatile responder;                     ///< Register-map callback, or nullptr.
+        uint8_t index;                                                ///< Bytes received in the current frame.
+        uint8_t length;                                               ///< Bytes of the current frame in `rx`.
+        bool selected;                                                ///< SS is low.
+        bool dropping;                                                ///< The current frame is being discarded.
+        mm::SPISlaveErrorCounters errors;                             ///< Collision and overflow counters.
+    };
+
+    SlaveState slave_state;
+
+    /**
+     * @brief Handles one byte received from the master.
+     *
+     * The response for the next byte is written to SPDR before anything else, to leave
+     * the master as much time as possible.
+     */
+    void slaveByte()
+    {
+        uint8_t in = SPDR;
+        uint8_t out = SPI_SLAVE_IDLE_BYTE;
+        mm::SPISlaveResponder responder = slave_state.responder;
+
+        if (responder)
+        {
+            out = responder(slave_state.index, in);
+        }
+        else
+        {
+            slave_state.tx.pop(out);
+        }
+
+        SPDR = out;
+        if (SPSR & (1 << WCOL))
+        {
+            // Reading SPSR and then SPDR clears the flag
+            (void)SPDR;
+            slave_state.errors.collisions++;
+        }
+
+        if (slave_state.index != 0xFF)
+        {
+            slave_state.index++;
+        }
+
+        if (!responder && !slave_state.dropping)
+        {
+            if (slave_state.rx.push(in))
+            {
+                slave_state.length++;
+            }
+            else
+            {
+                // Take back the part still stored (tryRead() may have taken some already);
+                // the frame is counted when SS rises
+                uint8_t stored = slave_state.rx.count();
+                slave_state.rx.unpush(slave_state.length < stored ? slave_state.length : stored);
+                slave_state.length = 0;
+                slave_state.dropping = true;
+            }
+        }
+    }
+}
+
+ISR(PCINT0_vect)
+{
+    bool selected = !(SPI_PIN & (1 << SPI_SS));
+    if (selected == slave_state.selected)
+    {
+        // Another pin of the port changed
+        return;
+    }
+    slave_state.selected = selected;
+
+    if (selected)
+    {
+        slave_state.index = 0;
+        slave_state.length = 0;
+        slave_state.dropping = slave_state.frames.isFull();
+        if (slave_state.responder)
+        {
+            SPDR = SPI_SLAVE_IDLE_BYTE;
+        }
+        return;
+    }
+
+    // The last byte may still be waiting for SPI_STC_vect, which has a lower priority
+    if (SPSR & (1 << SPIF))
+    {
+        slaveByte();
+    }
+
+    if (slave_state.responder || slave_state.index == 0)
+    {
+        return;
+    }
+
+    if (slave_state.dropping)
+    {
+        slave_state.errors.buffer_overflow++;
+    }
+    else
+    {
+        slave_state.frames.push(slave_state.length);
+    }
+}
+
+void mm::SPISlave::init()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        SPI_DDR |= (1 << SPI_MISO);
+        SPI_DDR &= ~((1 << SPI_MOSI) | (1 << SPI_SCK) | (1 << SPI_SS));
+
+        slave_state.rx.clear();
+        slave_state.tx.clear();
+        slave_state.frames.clear();
+        slave_state.index = 0;
+        slave_state.length = 0;
+        slave_state.selected = !(SPI_PIN & (1 << SPI_SS));
+        slave_state.dropping = false;
+        slave_state.errors = SPISlaveErrorCounters{0, 0};
+        spi::slaveInterrupt = slaveByte;
+
+        SPCR = (1 << SPE) | (1 << SPIE) | (settings.spcr & ((1 << DORD) | (1 << CPOL) | (1 << CPHA)));
+        SPDR = SPI_SLAVE_IDLE_BYTE;
+
+        PCMSK0 |= (1 << SPI_SS);
+        PCICR |= (1 << PCIE0);
+    }
+}
+
+void mm::SPISlave::setResponder(SPISlaveResponder responder)
+{
+    slave_state.responder = responder;
+}
+
+uint8_t mm::SPISlave::available() const
+{
+    return slave_state.rx.count();
+}
+
+bool mm::SPISlave::tryRead(uint8_t &data)
+{
+    return slave_state.rx.pop(data);
+}
+
+bool mm::SPISlave::write(uint8_t data)
+{
+    return slave_state.tx.push(data);
+}
+
+uint8_t mm::SPISlave::framesAvailable() const
+{
+    return slave_state.frames.count();
+}
+
+uint8_t mm::SPISlave::readFrame(uint8_t *buffer, uint8_t maxLength)
+{
+    uint8_t length;
+    if (!slave_state.frames.pop(length))
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        uint8_t data = 0;
+        slave_state.rx.pop(data);
+        if (i < maxLength)
+        {
+            buffer[i] = data;
+        }
+    }
+    return length;
+}
+
+mm::SPISlaveErrorCounters mm::SPISlave::errorCounters() const
+{
+    SPISlaveErrorCounters errors;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        errors = slave_state.errors;
+    }
+    return errors;
+}
+
+void mm::SPISlave::clearErrorCounters()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        slave_state.errors = SPISlaveErrorCounters{0, 0};
+    }
+}
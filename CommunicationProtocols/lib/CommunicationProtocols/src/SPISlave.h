@@ -0,0 +1,188 @@
+/**
+ * @file SPISlave.h
+ * @brief Header file for the interrupt-driven SPI slave.
+ *
+ * This file defines the `SPISlave` class, which lets the AVR act as an SPI peripheral of
+ * another processor. Bytes are exchanged in the `SPI_STC_vect` interrupt, either through
+ * receive and transmit ring buffers or through a register-map callback.
+ *
+ * @note This class inherits from the `CommunicationProtocol` class.
+ *
+ * @see CommunicationProtocol
+ */
+
+#ifndef SPI_SLAVE_H
+#define SPI_SLAVE_H
+
+#include "CommunicationProtocol.h"
+#include "SPIBus.h"
+
+#ifndef SPI_SLAVE_RX_BUFFER_SIZE
+#define SPI_SLAVE_RX_BUFFER_SIZE 32 ///< Size of the receive buffer.
+#endif
+
+#ifndef SPI_SLAVE_TX_BUFFER_SIZE
+#define SPI_SLAVE_TX_BUFFER_SIZE 32 ///< Size of the transmit buffer.
+#endif
+
+#ifndef SPI_SLAVE_FRAME_QUEUE_SIZE
+#define SPI_SLAVE_FRAME_QUEUE_SIZE 8 ///< Number of completed frames that can wait to be read.
+#endif
+
+#ifndef SPI_SLAVE_IDLE_BYTE
+#define SPI_SLAVE_IDLE_BYTE 0xFF ///< Byte sent when there is nothing else to send.
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Function called from the SPI interrupt for every byte received as a slave.
+     *
+     * @param index Position of the received byte in the current frame, 0 for the first
+     *              byte after SS went low.
+     * @param received The byte sent by the master.
+     * @return The byte to send while the master clocks the next one.
+     */
+    typedef uint8_t (*SPISlaveResponder)(uint8_t index, uint8_t received);
+
+    /**
+     * @brief Error counters of the SPI slave.
+     */
+    struct SPISlaveErrorCounters
+    {
+        uint16_t collisions;      ///< The master clocked the next byte before SPDR was reloaded (WCOL).
+        uint16_t buffer_overflow; ///< Frames dropped because the receive buffer or the frame queue was full.
+    };
+
+    /**
+     * @class SPISlave
+     * @brief Interrupt-driven SPI slave.
+     *
+     * Every received byte is handled in `SPI_STC_vect`, which immediately loads `SPDR`
+     * with the byte for the next transfer. Without a responder the received bytes go to
+     * a receive buffer and the response comes from a transmit buffer filled with
+     * `write()`. A falling edge on SS starts a new frame and a rising edge ends it, so
+     * messages can be read whole with `readFrame()`. A frame that does not fit into the
+     * receive buffer is dropped whole and counted in `buffer_overflow`, so a frame is
+     * never returned truncated.
+     *
+     * With a responder the bytes are passed to the callback instead, which returns the
+     * next response; this makes the AVR a register-mapped peripheral:
+     *
+     * @code
+     * uint8_t registers[16];
+     * uint8_t address;
+     * bool reading;
+     *
+     * // First byte: register address, bit 7 set for a read
+     * uint8_t respond(uint8_t index, uint8_t received)
+     * {
+     *     if (index == 0)
+     *     {
+     *         reading = received & 0x80;
+     *         address = received & 0x0F;
+     *     }
+     *     else if (!reading)
+     *     {
+     *         registers[address++ & 0x0F] = received;
+     *     }
+     *     return reading ? registers[address++ & 0x0F] : SPI_SLAVE_IDLE_BYTE;
+     * }
+     * @endcode
+     *
+     * @note The master has to leave a gap of a few microseconds between bytes for the
+     *       interrupt to run; missed reloads are counted as collisions. The class uses
+     *       `PCINT0_vect` for the SS line.
+     */
+    class SPISlave : public CommunicationProtocol
+    {
+    private:
+        SPISettings settings; ///< Mode and bit order; the clock comes from the master.
+
+    public:
+        /**
+         * @brief Constructs an SPI slave with the given mode and bit order.
+         *
+         * @param settings Mode and bit order, e.g. from `spiSettings()`.
+         */
+        SPISlave(SPISettings settings)
+            : settings(settings) {}
+
+        /**
+         * @brief Default constructor for the SPISlave class.
+         *
+         * Initializes the slave for mode 0, MSB first.
+         */
+        SPISlave()
+        {
+            settings = spiSettings(F_CPU, SPI_CLK);
+        }
+
+        /**
+         * @brief Initializes the SPI hardware as a slave and enables its interrupts.
+         *
+         * MISO becomes an output, MOSI, SCK and SS inputs. A pin change interrupt on SS
+         * tracks the frame boundaries. Global interrupts must be enabled.
+         */
+        void init() override;
+
+        /**
+         * @brief Installs or removes the register-map callback.
+         *
+         * @param responder The callback, or nullptr to use the ring buffers.
+         */
+        void setResponder(SPISlaveResponder responder);
+
+        /**
+         * @brief Returns the number of received bytes waiting to be read.
+         */
+        uint8_t available() const;
+
+        /**
+         * @brief Reads one received byte without waiting.
+         *
+         * @param data Receives the byte.
+         * @return True if a byte was available.
+         */
+        bool tryRead(uint8_t &data);
+
+        /**
+         * @brief Queues a byte to be sent on one of the next transfers.
+         *
+         * The byte for each transfer is loaded into `SPDR` when the previous transfer
+         * ends, so a byte queued now goes out at the earliest on the transfer after next.
+         *
+         * @param data The byte to send.
+         * @return True if the byte was queued, false if the transmit buffer is full.
+         */
+        bool write(uint8_t data);
+
+        /**
+         * @brief Returns the number of completed frames waiting to be read.
+         */
+        uint8_t framesAvailable() const;
+
+        /**
+         * @brief Reads the bytes of the oldest completed frame.
+         *
+         * Bytes that do not fit into the buffer are discarded. Read received data either
+         * frame by frame or byte by byte with `tryRead()`, not both.
+         *
+         * @param buffer Buffer for the frame.
+         * @param maxLength Size of the buffer.
+         * @return The length of the frame, 0 if no frame was complete.
+         */
+        uint8_t readFrame(uint8_t *buffer, uint8_t maxLength);
+
+        /**
+         * @brief Returns the collision and overflow counters.
+         */
+        SPISlaveErrorCounters errorCounters() const;
+
+        /**
+         * @brief Resets the collision and overflow counters.
+         */
+        void clearErrorCounters();
+    };
+}
+#endif // SPI_SLAVE_H
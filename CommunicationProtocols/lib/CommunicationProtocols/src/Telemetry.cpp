@@ -0,0 +1,67 @@
+#include "Telemetry.h"
+#include "Crc16.h"
+
+namespace
+{
+    /**
+     * @brief Stores a value in little-endian byte order.
+     */
+    void putLE(uint8_t *data, uint32_t value, uint8_t size)
+    {
+        for (uint8_t i = 0; i < size; i++)
+        {
+            data[i] = (uint8_t)value;
+            value >>= 8;
+        }
+    }
+
+    /**
+     * @brief Loads a little-endian value.
+     */
+    uint32_t getLE(const uint8_t *data, uint8_t size)
+    {
+        uint32_t value = 0;
+        for (uint8_t i = size; i > 0; i--)
+        {
+            value = (value << 8) | data[i - 1];
+        }
+        return value;
+    }
+}
+
+uint8_t mm::encodeTelemetry(const TelemetrySample &sample, uint8_t *frame)
+{
+    uint8_t payload[telemetry::payload_size + telemetry::crc_size];
+
+    payload[0] = telemetry::sample_type;
+    putLE(&payload[1], sample.sequence, 2);
+    putLE(&payload[3], sample.timestamp, 4);
+    putLE(&payload[7], (uint16_t)sample.temperature, 2);
+    putLE(&payload[9], sample.pressure, 4);
+    putLE(&payload[13], sample.humidity, 2);
+    putLE(&payload[telemetry::payload_size], crc16(payload, telemetry::payload_size), 2);
+
+    uint8_t length = cobsEncode(payload, sizeof(payload), frame);
+    frame[length++] = 0;
+    return length;
+}
+
+bool mm::decodeTelemetry(const uint8_t *frame, uint8_t len, TelemetrySample &sample)
+{
+    uint8_t payload[telemetry::frame_size];
+
+    if (len > sizeof(payload) ||
+        cobsDecode(frame, len, payload) != telemetry::payload_size + telemetry::crc_size ||
+        payload[0] != telemetry::sample_type ||
+        getLE(&payload[telemetry::payload_size], 2) != crc16(payload, telemetry::payload_size))
+    {
+        return false;
+    }
+
+    sample.sequence = getLE(&payload[1], 2);
+    sample.timestamp = getLE(&payload[3], 4);
+    sample.temperature = (int16_t)getLE(&payload[7], 2);
+    sample.pressure = getLE(&payload[9], 4);
+    sample.humidity = getLE(&payload[13], 2);
+    return true;
+}
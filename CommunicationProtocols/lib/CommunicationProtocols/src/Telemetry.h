@@ -0,0 +1,74 @@
+/**
+ * @file Telemetry.h
+ * @brief Binary telemetry frames for sensor samples.
+ *
+ * A frame is the little-endian payload below followed by its CRC-16/CCITT, COBS-encoded
+ * and terminated by a single zero byte:
+ *
+ * | Offset | Size | Field                               |
+ * |--------|------|-------------------------------------|
+ * | 0      | 1    | Frame type, `telemetry::sample_type` |
+ * | 1      | 2    | Sequence number                     |
+ * | 3      | 4    | Timestamp in milliseconds           |
+ * | 7      | 2    | Temperature in 0.01 degrees Celsius |
+ * | 9      | 4    | Pressure in Pa / 256                |
+ * | 13     | 2    | Humidity in 0.01 %RH                |
+ * | 15     | 2    | CRC-16/CCITT of bytes 0..14         |
+ *
+ * The file has no AVR dependencies, so host tools decode frames with the same code.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "Cobs.h"
+
+namespace mm
+{
+    /**
+     * @struct TelemetrySample
+     * @brief One sensor sample in fixed-point units.
+     */
+    struct TelemetrySample
+    {
+        uint16_t sequence;  ///< Incremented for every frame, so the receiver can count losses.
+        uint32_t timestamp; ///< Time of the sample in milliseconds.
+        int16_t temperature; ///< Temperature in 0.01 degrees Celsius.
+        uint32_t pressure;  ///< Pressure in Pa / 256.
+        uint16_t humidity;  ///< Humidity in 0.01 %RH.
+    };
+
+    namespace telemetry
+    {
+        constexpr uint8_t sample_type = 0x01;  ///< Frame type of a `TelemetrySample`.
+        constexpr uint8_t payload_size = 15;   ///< Bytes of a sample before the CRC.
+        constexpr uint8_t crc_size = 2;        ///< Bytes of the CRC.
+
+        /**
+         * @brief Largest encoded frame including the zero delimiter.
+         */
+        constexpr uint8_t frame_size = cobsMaxEncodedLength(payload_size + crc_size) + 1;
+    }
+
+    /**
+     * @brief Builds the frame of a sample.
+     *
+     * @param sample The sample to send.
+     * @param frame Buffer of `telemetry::frame_size` bytes.
+     * @return The length of the frame, including the trailing zero.
+     */
+    uint8_t encodeTelemetry(const TelemetrySample &sample, uint8_t *frame);
+
+    /**
+     * @brief Decodes a received frame.
+     *
+     * @param frame The encoded bytes without the trailing zero.
+     * @param len Number of encoded bytes.
+     * @param sample Receives the sample.
+     * @return True if the frame was well formed, of the sample type and had a valid CRC.
+     */
+    bool decodeTelemetry(const uint8_t *frame, uint8_t len, TelemetrySample &sample);
+}
+
+#endif // TELEMETRY_H
@@ -1,160 +1,91 @@
 #include "UART.h"
 #include <avr/io.h>
-#include <stdio.h>
 
-#define BAUD_PRESCALE(F_CPU, speed) (((F_CPU / (speed * 16UL))) - 1)
-
-void mm::UART::init()
+const mm::UARTOps *mm::UART::pollingOps(uint8_t usart_number)
 {
-    uint16_t ubrr_value = BAUD_PRESCALE(F_CPU, usart_speed);
-
     switch (usart_number)
     {
-    case 0: // USART0
-        UBRR0H = (uint8_t)(ubrr_value >> 8);
-        UBRR0L = (uint8_t)ubrr_value;
-        UCSR0B = (1 << TXEN0) | (1 << RXEN0);
-        UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
-        break;
-
-#if defined(UBRR1H) 
-    case 1:      
-        UBRR1H = (uint8_t)(ubrr_value >> 8);
-        UBRR1L = (uint8_t)ubrr_value;
-        UCSR1B = (1 << TXEN1) | (1 << RXEN1);
-        UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
-        break;
+#if defined(UDR1)
+    case 1:
+        return &UARTPortOps<1, UARTMode::Polling>::table;
 #endif
 
-#if defined(UBRR2H)
-    case 2: // USART2
-        UBRR2H = (uint8_t)(ubrr_value >> 8);
-        UBRR2L = (uint8_t)ubrr_value;
-        UCSR2B = (1 << TXEN2) | (1 << RXEN2);
-        UCSR2C = (1 << UCSZ21) | (1 << UCSZ20);
-        break;
+#if defined(UDR2)
+    case 2:
+        return &UARTPortOps<2, UARTMode::Polling>::table;
 #endif
 
-#if defined(UBRR3H)
-    case 3: // USART3
-        UBRR3H = (uint8_t)(ubrr_value >> 8);
-        UBRR3L = (uint8_t)ubrr_value;
-        UCSR3B = (1 << TXEN3) | (1 << RXEN3);
-        UCSR3C = (1 << UCSZ31) | (1 << UCSZ30);
-        break;
+#if defined(UDR3)
+    case 3:
+        return &UARTPortOps<3, UARTMode::Polling>::table;
 #endif
 
     default:
-        usart_number = 0;
-        UBRR0H = (uint8_t)(ubrr_value >> 8);
-        UBRR0L = (uint8_t)ubrr_value;
-        UCSR0B = (1 << TXEN0) | (1 << RXEN0);
-        UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
-        break;
+        return &UARTPortOps<0, UARTMode::Polling>::table;
     }
 }
 
+void mm::UART::init()
+{
+    ops->init(usart_speed, policy);
+}
+
 void mm::UART::transmitByte(uint8_t data)
 {
-    switch (usart_number)
-    {
-    case 0:
-        while (!(UCSR0A & (1 << UDRE0)))
-            ;
-        UDR0 = data;
-        break;
+    ops->transmitByte(data);
+}
 
-#if defined(UDR1)
-    case 1:
-        while (!(UCSR1A & (1 << UDRE1)))
-            ;
-        UDR1 = data;
-        break;
-#endif
+uint8_t mm::UART::receiveByte()
+{
+    return ops->receiveByte();
+}
 
-#if defined(UDR2)
-    case 1:
-        while (!(UCSR2A & (1 << UDRE2)))
-            ;
-        UDR2 = data;
-        break;
-#endif
+uint8_t mm::UART::available() const
+{
+    return ops->available();
+}
 
-#if defined(UDR3)
-    case 1:
-        while (!(UCSR3A & (1 << UDRE3)))
-            ;
-        UDR3 = data;
-        break;
-#endif
+bool mm::UART::tryReceiveByte(uint8_t &data)
+{
+    return ops->tryReceiveByte(data);
+}
 
-    default:
-        while (!(UCSR0A & (1 << UDRE0)))
-            ;
-        UDR0 = data;
-        break;
-    }
+void mm::UART::transmitString(const char *str)
+{
+    ops->transmitString(str);
 }
 
-uint8_t mm::UART::receiveByte()
+void mm::UART::receiveString(char *buffer, uint8_t maxLength)
 {
-    switch (usart_number)
-    {
-    case 0:
-        while (!(UCSR0A & (1 << RXC0)))
-            ;
-        return UDR0;
+    ops->receiveString(buffer, maxLength);
+}
 
-#if defined(UDR1)
-    case 1:
-        while (!(UCSR1A & (1 << RXC1)))
-            ;
-        return UDR1;
-#endif
+void mm::UART::flush()
+{
+    ops->flush();
+}
 
-#if defined(UDR2)
-    case 1:
-        while (!(UCSR2A & (1 << RXC2)))
-            ;
-        return UDR2;
-#endif
+uint16_t mm::UART::droppedBytes() const
+{
+    return ops->droppedBytes();
+}
 
-#if defined(UDR3)
-    case 1:
-        while (!(UCSR3A & (1 << RXC3)))
-            ;
-        return UDR3;
-#endif
+mm::UARTErrorCounters mm::UART::errorCounters() const
+{
+    return ops->errorCounters();
+}
 
-    default:
-        while (!(UCSR0A & (1 << RXC0)))
-            ;
-        return UDR0;
-        return 0;
-    }
+void mm::UART::clearErrorCounters()
+{
+    ops->clearErrorCounters();
 }
 
-void mm::UART::transmitString(const char *str)
+uint32_t mm::UART::achievedBaud() const
 {
-    while (*str != '\0')
-    {
-        transmitByte(*str);
-        str++;
-    }
+    return ops->achievedBaud();
 }
 
-void mm::UART::receiveString(char *buffer, uint8_t maxLength)
+int16_t mm::UART::baudError() const
 {
-    uint8_t i = 0;
-    char receivedChar;
-    while (i < maxLength - 1)
-    {
-        receivedChar = receiveByte();
-        if (receivedChar == '\n' || receivedChar == '\r')
-        {
-            break;
-        }
-        buffer[i++] = receivedChar;
-    }
-    buffer[i] = '\0';
+    return baud::error(ops->achievedBaud(), usart_speed);
 }
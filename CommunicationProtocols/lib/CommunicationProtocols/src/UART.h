@@ -1,108 +1,328 @@
 /**
  * @file UART.h
  * @brief Header file for the UART communication protocol.
- * 
- * This file defines the `UART` class, which provides methods for initializing and operating 
- * the UART protocol, including communication with UART devices (transmitting and receiving 
- * data, and transmitting strings).
- * 
- * @note This class inherits from the `CommunicationProtocol` class.
- * 
+ *
+ * This file defines the `UART` class, which provides methods for initializing and operating
+ * the UART protocol, including communication with UART devices (transmitting and receiving
+ * data, and transmitting strings), and the `StaticUART` class template, which does the same
+ * for a USART and transfer mode fixed at compile time.
+ *
+ * @note Both classes inherit from the `CommunicationProtocol` class.
+ *
  * @see CommunicationProtocol
+ * @see UARTPort
  */
 
 #ifndef UART_H
 #define UART_H
 
 #include "CommunicationProtocol.h"
+#include "UARTPort.h"
 
 namespace mm
 {
+    /**
+     * @struct UARTOps
+     * @brief Table of the `UARTPort` functions for one USART and transfer mode.
+     *
+     * The `UART` class picks its table once in the constructor, so every later call is a
+     * single indirect call into code where the USART registers are compile-time constants.
+     */
+    struct UARTOps
+    {
+        void (*init)(uint32_t speed, TxFullPolicy policy);
+        void (*transmitByte)(uint8_t data);
+        uint8_t (*receiveByte)();
+        uint8_t (*available)();
+        bool (*tryReceiveByte)(uint8_t &data);
+        void (*transmitString)(const char *str);
+        void (*receiveString)(char *buffer, uint8_t maxLength);
+        void (*flush)();
+        uint16_t (*droppedBytes)();
+        UARTErrorCounters (*errorCounters)();
+        void (*clearErrorCounters)();
+        uint32_t (*achievedBaud)();
+    };
+
+    /**
+     * @struct UARTPortOps
+     * @brief Holds the `UARTOps` table of `UARTPort<N, Mode>`.
+     *
+     * @tparam N The USART instance number.
+     * @tparam Mode The data transfer mode.
+     */
+    template <uint8_t N, UARTMode Mode>
+    struct UARTPortOps
+    {
+        typedef UARTPort<N, Mode> Port;
+        static const UARTOps table;
+    };
+
+    template <uint8_t N, UARTMode Mode>
+    const UARTOps UARTPortOps<N, Mode>::table = {
+        Port::init,
+        Port::transmitByte,
+        Port::receiveByte,
+        Port::available,
+        Port::tryReceiveByte,
+        Port::transmitString,
+        Port::receiveString,
+        Port::flush,
+        Port::droppedBytes,
+        Port::errorCounters,
+        Port::clearErrorCounters,
+        Port::achievedBaud,
+    };
+
     /**
      * @class UART
      * @brief Class for UART communication protocol.
-     * 
-     * This class provides functions to initialize the UART communication, 
+     *
+     * This class provides functions to initialize the UART communication,
      * transmit and receive data, and manage string communication.
-     * 
-     * It supports a configurable speed and USART number for different 
+     *
+     * It supports a configurable speed and USART number for different
      * UART instances.
-     * 
+     *
+     * In `UARTMode::Interrupt` transmitted bytes are placed in a ring buffer shared by all
+     * objects driving the same USART and are sent from the `USART_UDRE` interrupt, so
+     * `transmitByte()` and `transmitString()` return as soon as the data is queued.
+     * Received bytes are collected by the `USART_RX` interrupt into a second ring buffer,
+     * so nothing is lost while the program is busy elsewhere.
+     * Global interrupts must be enabled with `sei()` for the buffers to work.
+     *
+     * The class is a thin runtime wrapper around `UARTPort`. Only the constructor that takes
+     * a `UARTMode` refers to the interrupt mode code, so a program that constructs its UARTs
+     * with a USART number and a speed links neither the handlers nor the buffers. Code that
+     * knows its USART at compile time can use `StaticUART` and avoid the indirect call.
+     *
+     * @code
+     * mm::UART uart(0, 9600);
+     * uart.init();
+     * uart << "T=" << mm::fixed(2315, 2) << '\n';
+     * @endcode
+     *
      * @note The class assumes a default speed of 9600 and USART number 0 if no values are provided.
      */
-    class UART : public CommunicationProtocol
+    class UART : public CommunicationProtocol, public Print<UART>
     {
     private:
         uint32_t usart_speed; ///< speed for UART communication.
         uint8_t usart_number; ///< USART instance number.
+        TxFullPolicy policy;  ///< Behaviour when the transmit buffer is full.
+        const UARTOps *ops;   ///< Functions of the selected USART and mode.
+
+        /**
+         * @brief Returns the polling mode function table for a USART.
+         *
+         * Unknown USART numbers fall back to USART0.
+         *
+         * @param usart_number The USART instance number.
+         * @return The function table.
+         */
+        static const UARTOps *pollingOps(uint8_t usart_number);
+
+        /**
+         * @brief Returns the interrupt mode function table for a USART.
+         *
+         * Unknown USART numbers fall back to USART0.
+         *
+         * @param usart_number The USART instance number.
+         * @return The function table.
+         */
+        static const UARTOps *interruptOps(uint8_t usart_number);
 
     public:
         /**
-         * @brief Constructs a UART object with specified USART number and speed.
-         * 
-         * Initializes the UART interface with a specific USART number and speed.
-         * 
+         * @brief Constructs a polling UART object with specified USART number and speed.
+         *
          * @param usart_number The USART instance number.
          * @param speed The speed for UART communication.
          */
-        UART(uint8_t usart_number, uint32_t speed) 
-            : usart_speed(speed), usart_number(usart_number) {}
+        UART(uint8_t usart_number, uint32_t speed)
+            : usart_speed(speed), usart_number(usart_number), policy(TxFullPolicy::Block),
+              ops(pollingOps(usart_number)) {}
+
+        /**
+         * @brief Constructs a UART object with specified USART number, speed and mode.
+         *
+         * @param usart_number The USART instance number.
+         * @param speed The speed for UART communication.
+         * @param mode The data transfer mode.
+         * @param policy The behaviour when the transmit buffer is full (blocking by default).
+         */
+        UART(uint8_t usart_number, uint32_t speed, UARTMode mode,
+             TxFullPolicy policy = TxFullPolicy::Block);
 
         /**
          * @brief Default constructor for the UART class.
-         * 
-         * Initializes the UART with a default speed of 9600 and USART number 0.
+         *
+         * Initializes the UART with a default speed of 9600, USART number 0 and polling mode.
          */
-        UART(){
-            usart_speed = 9600;
-            usart_number = 0;
-        }
+        UART()
+            : usart_speed(9600), usart_number(0), policy(TxFullPolicy::Block),
+              ops(pollingOps(0)) {}
 
         /**
          * @brief Initializes the UART communication protocol.
-         * 
-         * This method configures the UART interface, including the speed 
-         * and the USART instance.
+         *
+         * The divider and the U2X double-speed bit are chosen for the lowest speed error.
          */
         void init() override;
 
         /**
          * @brief Transmits a single byte of data over UART.
-         * 
-         * This function sends a single byte of data over the UART communication channel.
-         * 
+         *
+         * In interrupt mode the byte is only queued and the full buffer policy applies.
+         *
          * @param data The byte of data to transmit.
          */
         void transmitByte(uint8_t data);
 
         /**
          * @brief Receives a single byte of data via UART.
-         * 
-         * This function reads a byte of data from the UART communication channel.
-         * 
+         *
+         * In interrupt mode it waits until the receive buffer holds a byte.
+         *
          * @return The byte of data received from UART.
          */
         uint8_t receiveByte();
 
         /**
-         * @brief Transmits a string of characters over UART.
-         * 
-         * This function sends a null-terminated string over the UART communication channel.
-         * 
+         * @brief Returns the number of received bytes that can be read without waiting.
+         *
+         * In polling mode this is 1 when the hardware holds an unread byte and 0 otherwise.
+         *
+         * @return The number of bytes available.
+         */
+        uint8_t available() const;
+
+        /**
+         * @brief Receives a byte if one is available, without waiting.
+         *
+         * @param data Reference that receives the byte.
+         * @return True if a byte was received, false if none was available.
+         */
+        bool tryReceiveByte(uint8_t &data);
+
+        /**
+         * @brief Transmits a null-terminated string over UART.
+         *
          * @param str The string of characters to transmit.
          */
         void transmitString(const char *str);
 
         /**
          * @brief Receives a string of characters via UART.
-         * 
-         * This function reads characters from the UART communication channel until 
-         * the specified maximum length is reached or a null terminator is encountered.
-         * 
+         *
+         * Reads characters until the specified maximum length is reached or a null
+         * terminator is encountered.
+         *
          * @param buffer A pointer to the buffer to store the received string.
          * @param maxLength The maximum number of characters to receive.
          */
         void receiveString(char *buffer, uint8_t maxLength);
+
+        /**
+         * @brief Waits until all queued bytes have been shifted out.
+         */
+        void flush();
+
+        /**
+         * @brief Returns the number of bytes discarded by the `Drop` and `Overwrite` policies.
+         *
+         * @return The number of discarded bytes since initialization.
+         */
+        uint16_t droppedBytes() const;
+
+        /**
+         * @brief Returns a snapshot of the receive error counters.
+         *
+         * @return The receive error counters.
+         */
+        UARTErrorCounters errorCounters() const;
+
+        /**
+         * @brief Resets the receive error counters to zero.
+         */
+        void clearErrorCounters();
+
+        /**
+         * @brief Returns the speed currently programmed into the USART.
+         *
+         * @return The achieved speed in baud.
+         */
+        uint32_t achievedBaud() const;
+
+        /**
+         * @brief Returns the deviation of the achieved speed from the requested one.
+         *
+         * The receiver tolerates a total error of both ends of about 2 % for 8N1, or 1.5 %
+         * with U2X (ATmega328P datasheet, tables 20-2 and 20-3). At 16 MHz 115200 baud is
+         * +2.12 % off and outside this range; 57600 baud is -0.79 %.
+         *
+         * @return The error in hundredths of a percent, e.g. 212 for +2.12 %.
+         */
+        int16_t baudError() const;
+    };
+
+    /**
+     * @class StaticUART
+     * @brief UART with the USART and the transfer mode fixed at compile time.
+     *
+     * This class adds the speed and the full buffer policy to `UARTPort`, so the USART can
+     * be set up through the common `init()` interface. All operations are direct register
+     * accesses without the function table of `UART`, and a polling UART links no interrupt
+     * code.
+     *
+     * Formatted output comes from the `Print` mixin of `UARTPort`.
+     *
+     * @code
+     * mm::StaticUART<0, mm::UARTMode::Interrupt> uart(57600);
+     * uart.init();
+     * @endcode
+     *
+     * @tparam N The USART instance number.
+     * @tparam Mode The data transfer mode.
+     */
+    template <uint8_t N = 0, UARTMode Mode = UARTMode::Polling>
+    class StaticUART : public CommunicationProtocol, public UARTPort<N, Mode>
+    {
+    private:
+        typedef UARTPort<N, Mode> Port;
+
+        uint32_t usart_speed; ///< speed for UART communication.
+        TxFullPolicy policy;  ///< Behaviour when the transmit buffer is full.
+
+    public:
+        /**
+         * @brief Constructs a StaticUART object with the specified speed.
+         *
+         * @param speed The speed for UART communication.
+         * @param policy The behaviour when the transmit buffer is full (blocking by default).
+         */
+        explicit StaticUART(uint32_t speed = 9600, TxFullPolicy policy = TxFullPolicy::Block)
+            : usart_speed(speed), policy(policy) {}
+
+        /**
+         * @brief Initializes the UART communication protocol.
+         *
+         * The divider and the U2X double-speed bit are chosen for the lowest speed error.
+         */
+        void init() override
+        {
+            Port::init(usart_speed, policy);
+        }
+
+        /**
+         * @brief Returns the deviation of the achieved speed from the requested one.
+         *
+         * @return The error in hundredths of a percent, see `UART::baudError()`.
+         */
+        int16_t baudError() const
+        {
+            return baud::error(Port::achievedBaud(), usart_speed);
+        }
     };
 }
 
@@ -0,0 +1,35 @@
+#include "UART.h"
+#include <avr/io.h>
+
+// Kept apart from UART.cpp: the interrupt mode tables refer to the USART handlers in
+// UARTVectorsN.cpp, so only programs that pass a UARTMode link them
+
+const mm::UARTOps *mm::UART::interruptOps(uint8_t usart_number)
+{
+    switch (usart_number)
+    {
+#if defined(UDR1)
+    case 1:
+        return &UARTPortOps<1, UARTMode::Interrupt>::table;
+#endif
+
+#if defined(UDR2)
+    case 2:
+        return &UARTPortOps<2, UARTMode::Interrupt>::table;
+#endif
+
+#if defined(UDR3)
+    case 3:
+        return &UARTPortOps<3, UARTMode::Interrupt>::table;
+#endif
+
+    default:
+        return &UARTPortOps<0, UARTMode::Interrupt>::table;
+    }
+}
+
+mm::UART::UART(uint8_t usart_number, uint32_t speed, UARTMode mode, TxFullPolicy policy)
+    : usart_speed(speed), usart_number(usart_number), policy(policy),
+      ops(mode == UARTMode::Interrupt ? interruptOps(usart_number) : pollingOps(usart_number))
+{
+}
@@ -0,0 +1,595 @@
+/**
+ * @file UARTPort.h
+ * @brief Header file for the compile-time selected UART port.
+ *
+ * This file defines the `USARTRegisters` traits, which map a USART number to its
+ * registers and bit positions, and the `UARTPort` class template, which implements the
+ * UART operations on top of them. Because the USART and the transfer mode are template
+ * parameters, every register access is resolved by the compiler and a byte operation
+ * compiles down to a status bit test and a single store or load.
+ *
+ * The interrupt handlers of USART `N` live in UARTVectorsN.cpp. Only
+ * `UARTPort<N, UARTMode::Interrupt>::init()` refers to that file, so when the library is
+ * linked as an archive a program that only polls gets neither the handlers nor the ring
+ * buffers.
+ *
+ * @see UART
+ */
+
+#ifndef UART_PORT_H
+#define UART_PORT_H
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "Register.h"
+#include "RingBuffer.h"
+#include "BaudRate.h"
+#include "Print.h"
+
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 64 ///< Size of the per-USART transmit buffer used in interrupt mode.
+#endif
+
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 64 ///< Size of the per-USART receive buffer used in interrupt mode.
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Selects how the UART moves data between the program and the hardware.
+     */
+    enum class UARTMode : uint8_t
+    {
+        Polling,  ///< Every byte busy-waits on the USART status flags.
+        Interrupt ///< Bytes are queued in a ring buffer and moved by the USART interrupts.
+    };
+
+    /**
+     * @brief Selects what happens when a byte is queued while the transmit buffer is full.
+     */
+    enum class TxFullPolicy : uint8_t
+    {
+        Block,    ///< Wait until the interrupt has made room for the byte.
+        Drop,     ///< Discard the new byte.
+        Overwrite ///< Discard the oldest queued byte to make room for the new one.
+    };
+
+    /**
+     * @brief Receive error counters of one USART, updated by the `USART_RX` interrupt.
+     */
+    struct UARTErrorCounters
+    {
+        uint16_t data_overrun;    ///< Hardware data overruns (DOR), bytes lost before the ISR ran.
+        uint16_t frame_error;     ///< Bytes received with a frame error (FE), discarded.
+        uint16_t buffer_overflow; ///< Bytes discarded because the receive buffer was full.
+    };
+
+    /**
+     * @struct USARTRegisters
+     * @brief Registers and bit positions of USART number `N`.
+     *
+     * Only the USARTs present on the selected microcontroller are specialized, so using a
+     * missing one is a compile error instead of a silent fallback to USART0.
+     *
+     * @tparam N The USART instance number.
+     */
+    template <uint8_t N>
+    struct USARTRegisters;
+
+#define MM_USART_REGISTERS(n)                                          \
+    extern const uint8_t usart##n##_vectors;                           \
+    template <>                                                        \
+    struct USARTRegisters<n>                                           \
+    {                                                                  \
+        static Register &udr() { return UDR##n; }                      \
+        static Register &ucsra() { return UCSR##n##A; }                \
+        static Register &ucsrb() { return UCSR##n##B; }                \
+        static Register &ucsrc() { return UCSR##n##C; }                \
+        static Register &ubrrh() { return UBRR##n##H; }                \
+        static Register &ubrrl() { return UBRR##n##L; }                \
+        static const uint8_t &vectors() { return usart##n##_vectors; } \
+        static constexpr uint8_t rxc = RXC##n;                         \
+        static constexpr uint8_t txc = TXC##n;                         \
+        static constexpr uint8_t udre = UDRE##n;                       \
+        static constexpr uint8_t fe = FE##n;                           \
+        static constexpr uint8_t dor = DOR##n;                         \
+        static constexpr uint8_t u2x = U2X##n;                         \
+        static constexpr uint8_t mpcm = MPCM##n;                       \
+        static constexpr uint8_t rxcie = RXCIE##n;                     \
+        static constexpr uint8_t udrie = UDRIE##n;                     \
+        static constexpr uint8_t rxen = RXEN##n;                       \
+        static constexpr uint8_t txen = TXEN##n;                       \
+        static constexpr uint8_t ucsz1 = UCSZ##n##1;                   \
+        static constexpr uint8_t ucsz0 = UCSZ##n##0;                   \
+    };
+
+    MM_USART_REGISTERS(0)
+#if defined(UDR1)
+    MM_USART_REGISTERS(1)
+#endif
+#if defined(UDR2)
+    MM_USART_REGISTERS(2)
+#endif
+#if defined(UDR3)
+    MM_USART_REGISTERS(3)
+#endif
+
+#undef MM_USART_REGISTERS
+
+    /**
+     * @struct UARTState
+     * @brief Interrupt mode state of USART number `N`.
+     *
+     * The buffers belong to the hardware rather than to a UART object, so every object
+     * driving the same USART shares them.
+     *
+     * @tparam N The USART instance number.
+     */
+    template <uint8_t N>
+    struct UARTState
+    {
+        static RingBuffer<uint8_t, UART_TX_BUFFER_SIZE> tx; ///< Bytes waiting for the UDRE interrupt.
+        static RingBuffer<uint8_t, UART_RX_BUFFER_SIZE> rx; ///< Bytes collected by the RX interrupt.
+        static volatile uint16_t dropped;                   ///< Bytes discarded by the full buffer policy.
+        static volatile bool in_flight;                     ///< Set when the ISR cleared TXC by sending a byte.
+        static TxFullPolicy policy;                         ///< Behaviour when the transmit buffer is full.
+        static UARTErrorCounters errors;                    ///< Receive error counters.
+    };
+
+    template <uint8_t N>
+    RingBuffer<uint8_t, UART_TX_BUFFER_SIZE> UARTState<N>::tx;
+    template <uint8_t N>
+    RingBuffer<uint8_t, UART_RX_BUFFER_SIZE> UARTState<N>::rx;
+    template <uint8_t N>
+    volatile uint16_t UARTState<N>::dropped;
+    template <uint8_t N>
+    volatile bool UARTState<N>::in_flight;
+    template <uint8_t N>
+    TxFullPolicy UARTState<N>::policy;
+    template <uint8_t N>
+    UARTErrorCounters UARTState<N>::errors;
+
+    /**
+     * @brief Selects the implementation of a `UARTPort` operation for a transfer mode.
+     *
+     * Each mode has its own overload, and a member of a class template is only
+     * instantiated when it is called, so a polling port never refers to `UARTState`.
+     */
+    template <UARTMode Mode>
+    struct UARTModeTag
+    {
+    };
+
+    /**
+     * @class UARTPort
+     * @brief UART operations on a USART selected at compile time.
+     *
+     * All operations are static; the class only names a USART and a transfer mode. In
+     * `UARTMode::Interrupt` the `USART_UDRE` and `USART_RX` interrupts defined in
+     * UARTVectorsN.cpp move the data, and global interrupts must be enabled with `sei()`.
+     * An object of the class is empty and adds the `Print` formatting functions:
+     *
+     * @code
+     * mm::UARTPort<0, mm::UARTMode::Interrupt> console;
+     * console.init(9600);
+     * console << MM_F("T=") << mm::fixed(2315, 2) << '\n';
+     * @endcode
+     *
+     * @tparam N The USART instance number.
+     * @tparam Mode The data transfer mode.
+     */
+    template <uint8_t N, UARTMode Mode = UARTMode::Polling>
+    class UARTPort : public Print<UARTPort<N, Mode>>
+    {
+    private:
+        typedef USARTRegisters<N> Regs;
+        typedef UARTState<N> State;
+        typedef UARTModeTag<Mode> Tag;
+        typedef UARTModeTag<UARTMode::Polling> PollingTag;
+        typedef UARTModeTag<UARTMode::Interrupt> InterruptTag;
+
+        static bool interruptsEnabled()
+        {
+            return SREG & (1 << SREG_I);
+        }
+
+    public:
+        /**
+         * @brief Initializes the USART for 8N1 frames at the given speed.
+         *
+         * The UBRR value and the U2X bit are chosen by `baudSetting()`; with a constant
+         * speed the calculation is folded by the compiler.
+         *
+         * @param speed The speed for UART communication.
+         * @param policy The behaviour when the transmit buffer is full (interrupt mode only).
+         */
+        static void init(uint32_t speed, TxFullPolicy policy = TxFullPolicy::Block)
+        {
+            init(baudSetting(F_CPU, speed), policy);
+        }
+
+        /**
+         * @brief Initializes the USART for 8N1 frames with precomputed baud registers.
+         *
+         * @code
+         * constexpr mm::BaudSetting baud = mm::baudSetting(F_CPU, 57600);
+         * static_assert(mm::baudError(F_CPU, baud, 57600) > -150, "baud error too large");
+         * Console::init(baud);
+         * @endcode
+         *
+         * @param baud The UBRR value and U2X bit to program.
+         * @param policy The behaviour when the transmit buffer is full (interrupt mode only).
+         */
+        static void init(BaudSetting baud, TxFullPolicy policy = TxFullPolicy::Block)
+        {
+            Regs::ubrrh() = (uint8_t)(baud.ubrr >> 8);
+            Regs::ubrrl() = (uint8_t)baud.ubrr;
+            Regs::ucsra() = baud.u2x ? (1 << Regs::u2x) : 0;
+            Regs::ucsrb() = (1 << Regs::txen) | (1 << Regs::rxen);
+            Regs::ucsrc() = (1 << Regs::ucsz1) | (1 << Regs::ucsz0);
+            initBuffers(policy, Tag());
+        }
+
+        /**
+         * @brief Returns the speed currently programmed into the USART.
+         *
+         * @return The achieved speed in baud.
+         */
+        static uint32_t achievedBaud()
+        {
+            BaudSetting baud;
+            baud.ubrr = ((uint16_t)(Regs::ubrrh() & 0x0F) << 8) | Regs::ubrrl();
+            baud.u2x = Regs::ucsra() & (1 << Regs::u2x);
+            return mm::achievedBaud(F_CPU, baud);
+        }
+
+        /**
+         * @brief Transmits a single byte of data.
+         *
+         * In interrupt mode the byte is only queued and the full buffer policy applies.
+         *
+         * @param data The byte of data to transmit.
+         */
+        static void transmitByte(uint8_t data)
+        {
+            transmitByte(data, Tag());
+        }
+
+        /**
+         * @brief Receives a single byte of data, waiting until one is available.
+         *
+         * @return The byte of data received.
+         */
+        static uint8_t receiveByte()
+        {
+            return receiveByte(Tag());
+        }
+
+        /**
+         * @brief Returns the number of received bytes that can be read without waiting.
+         *
+         * In polling mode this is 1 when the hardware holds an unread byte and 0 otherwise.
+         */
+        static uint8_t available()
+        {
+            return available(Tag());
+        }
+
+        /**
+         * @brief Receives a byte if one is available, without waiting.
+         *
+         * @param data Reference that receives the byte.
+         * @return True if a byte was received, false if none was available.
+         */
+        static bool tryReceiveByte(uint8_t &data)
+        {
+            return tryReceiveByte(data, Tag());
+        }
+
+        /**
+         * @brief Transmits a null-terminated string.
+         *
+         * @param str The string of characters to transmit.
+         */
+        static void transmitString(const char *str)
+        {
+            while (*str != '\0')
+            {
+                transmitByte(*str);
+                str++;
+            }
+        }
+
+        /**
+         * @brief Receives a line of text until a line terminator or the length limit.
+         *
+         * @param buffer A pointer to the buffer to store the received string.
+         * @param maxLength The size of the buffer, including the null terminator.
+         */
+        static void receiveString(char *buffer, uint8_t maxLength)
+        {
+            uint8_t i = 0;
+            while (i < maxLength - 1)
+            {
+                uint8_t receivedChar = receiveByte();
+                if (receivedChar == '\n' || receivedChar == '\r')
+                {
+                    break;
+                }
+                buffer[i++] = receivedChar;
+            }
+            buffer[i] = '\0';
+        }
+
+        /**
+         * @brief Waits until all queued bytes have been shifted out.
+         *
+         * In interrupt mode this drains the transmit buffer and waits for the last byte to
+         * leave the shift register. In polling mode it only waits for the data register to
+         * become empty.
+         */
+        static void flush()
+        {
+            flush(Tag());
+            while (!(Regs::ucsra() & (1 << Regs::udre)))
+                ;
+        }
+
+        /**
+         * @brief Returns the number of bytes discarded by the `Drop` and `Overwrite` policies.
+         *
+         * Always 0 in polling mode, which never discards.
+         */
+        static uint16_t droppedBytes()
+        {
+            return droppedBytes(Tag());
+        }
+
+        /**
+         * @brief Returns a snapshot of the receive error counters (interrupt mode only).
+         */
+        static UARTErrorCounters errorCounters()
+        {
+            return errorCounters(Tag());
+        }
+
+        /**
+         * @brief Resets the receive error counters to zero.
+         */
+        static void clearErrorCounters()
+        {
+            clearErrorCounters(Tag());
+        }
+
+        /**
+         * @brief Body of the `USART_UDRE` interrupt.
+         *
+         * Sends the next queued byte or disables the interrupt when the buffer is empty.
+         * Writing TXC together with UDR clears the transmit complete flag, so `flush()`
+         * can tell when the last queued byte has left the shift register.
+         */
+        static void udreInterrupt()
+        {
+            uint8_t data;
+            if (State::tx.pop(data))
+            {
+                Regs::ucsra() = (Regs::ucsra() & ((1 << Regs::u2x) | (1 << Regs::mpcm))) | (1 << Regs::txc);
+                Regs::udr() = data;
+                State::in_flight = true;
+            }
+            else
+            {
+                Regs::ucsrb() &= ~(1 << Regs::udrie);
+            }
+        }
+
+        /**
+         * @brief Body of the `USART_RX` interrupt.
+         *
+         * Moves the received byte into the receive buffer and accounts for errors.
+         * UCSRnA has to be read before UDRn, because reading UDRn clears the error flags.
+         */
+        static void rxInterrupt()
+        {
+            uint8_t status = Regs::ucsra();
+            uint8_t data = Regs::udr();
+
+            if (status & (1 << Regs::dor))
+            {
+                State::errors.data_overrun++;
+            }
+
+            if (status & (1 << Regs::fe))
+            {
+                State::errors.frame_error++;
+                return;
+            }
+
+            if (!State::rx.push(data))
+            {
+                State::errors.buffer_overflow++;
+            }
+        }
+
+    private:
+        static void initBuffers(TxFullPolicy, PollingTag)
+        {
+        }
+
+        static void initBuffers(TxFullPolicy policy, InterruptTag)
+        {
+            // The load links UARTVectorsN.cpp, which holds the interrupt handlers
+            (void)*(const volatile uint8_t *)&Regs::vectors();
+            State::tx.clear();
+            State::rx.clear();
+            State::dropped = 0;
+            State::in_flight = false;
+            State::policy = policy;
+            State::errors = UARTErrorCounters();
+            Regs::ucsrb() |= (1 << Regs::rxcie);
+        }
+
+        static void transmitByte(uint8_t data, PollingTag)
+        {
+            while (!(Regs::ucsra() & (1 << Regs::udre)))
+                ;
+            Regs::udr() = data;
+        }
+
+        static void transmitByte(uint8_t data, InterruptTag)
+        {
+            if (!State::tx.push(data))
+            {
+                transmitByteFull(data);
+            }
+            Regs::ucsrb() |= (1 << Regs::udrie);
+        }
+
+        static uint8_t receiveByte(PollingTag)
+        {
+            while (!(Regs::ucsra() & (1 << Regs::rxc)))
+                ;
+            return Regs::udr();
+        }
+
+        static uint8_t receiveByte(InterruptTag)
+        {
+            uint8_t data;
+            while (!State::rx.pop(data))
+            {
+                busyWait();
+            }
+            return data;
+        }
+
+        static uint8_t available(PollingTag)
+        {
+            return (Regs::ucsra() & (1 << Regs::rxc)) ? 1 : 0;
+        }
+
+        static uint8_t available(InterruptTag)
+        {
+            return State::rx.count();
+        }
+
+        static bool tryReceiveByte(uint8_t &data, PollingTag)
+        {
+            if (!(Regs::ucsra() & (1 << Regs::rxc)))
+            {
+                return false;
+            }
+            data = Regs::udr();
+            return true;
+        }
+
+        static bool tryReceiveByte(uint8_t &data, InterruptTag)
+        {
+            return State::rx.pop(data);
+        }
+
+        static void flush(PollingTag)
+        {
+        }
+
+        static void flush(InterruptTag)
+        {
+            while (!State::tx.isEmpty() || (Regs::ucsrb() & (1 << Regs::udrie)))
+            {
+                if (!interruptsEnabled())
+                {
+                    while (!(Regs::ucsra() & (1 << Regs::udre)))
+                        ;
+                    udreInterrupt();
+                }
+            }
+
+            if (State::in_flight)
+            {
+                while (!(Regs::ucsra() & (1 << Regs::txc)))
+                    ;
+                State::in_flight = false;
+            }
+        }
+
+        static uint16_t droppedBytes(PollingTag)
+        {
+            return 0;
+        }
+
+        static uint16_t droppedBytes(InterruptTag)
+        {
+            uint16_t dropped = 0;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                dropped = State::dropped;
+            }
+            return dropped;
+        }
+
+        static UARTErrorCounters errorCounters(PollingTag)
+        {
+            return UARTErrorCounters();
+        }
+
+        static UARTErrorCounters errorCounters(InterruptTag)
+        {
+            UARTErrorCounters counters;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                counters = State::errors;
+            }
+            return counters;
+        }
+
+        static void clearErrorCounters(PollingTag)
+        {
+        }
+
+        static void clearErrorCounters(InterruptTag)
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                State::errors = UARTErrorCounters();
+            }
+        }
+
+        /**
+         * @brief Applies the full buffer policy; kept out of line so the fast path stays small.
+         *
+         * @param data The byte of data to queue.
+         */
+        static void __attribute__((noinline)) transmitByteFull(uint8_t data)
+        {
+            while (!State::tx.push(data))
+            {
+                if (State::policy == TxFullPolicy::Drop)
+                {
+                    State::dropped = State::dropped + 1;
+                    return;
+                }
+
+                if (State::policy == TxFullPolicy::Overwrite)
+                {
+                    // Keep the ISR away from the tail while the producer moves it.
+                    Regs::ucsrb() &= ~(1 << Regs::udrie);
+                    State::tx.discard();
+                    State::dropped = State::dropped + 1;
+                    continue;
+                }
+
+                if (!interruptsEnabled())
+                {
+                    // Interrupts are off, so the buffer will never drain on its own; send
+                    // the oldest byte by hand to make room instead of deadlocking.
+                    while (!(Regs::ucsra() & (1 << Regs::udre)))
+                        ;
+                    udreInterrupt();
+                }
+                busyWait();
+            }
+        }
+    };
+}
+
+#endif // UART_PORT_H
@@ -0,0 +1,23 @@
+#include "UARTPort.h"
+#include <avr/interrupt.h>
+
+// Referenced by UARTPort<0, UARTMode::Interrupt>::init(), which links this file
+const uint8_t mm::usart0_vectors = 0;
+
+#if defined(USART_UDRE_vect)
+ISR(USART_UDRE_vect)
+#else
+ISR(USART0_UDRE_vect)
+#endif
+{
+    mm::UARTPort<0, mm::UARTMode::Interrupt>::udreInterrupt();
+}
+
+#if defined(USART_RX_vect)
+ISR(USART_RX_vect)
+#else
+ISR(USART0_RX_vect)
+#endif
+{
+    mm::UARTPort<0, mm::UARTMode::Interrupt>::rxInterrupt();
+}
@@ -0,0 +1,17 @@
+#include "UARTPort.h"
+#include <avr/interrupt.h>
+
+#if defined(UDR1)
+// Referenced by UARTPort<1, UARTMode::Interrupt>::init(), which links this file
+const uint8_t mm::usart1_vectors = 0;
+
+ISR(USART1_UDRE_vect)
+{
+    mm::UARTPort<1, mm::UARTMode::Interrupt>::udreInterrupt();
+}
+
+ISR(USART1_RX_vect)
+{
+    mm::UARTPort<1, mm::UARTMode::Interrupt>::rxInterrupt();
+}
+#endif
@@ -0,0 +1,17 @@
+#include "UARTPort.h"
+#include <avr/interrupt.h>
+
+#if defined(UDR2)
+// Referenced by UARTPort<2, UARTMode::Interrupt>::init(), which links this file
+const uint8_t mm::usart2_vectors = 0;
+
+ISR(USART2_UDRE_vect)
+{
+    mm::UARTPort<2, mm::UARTMode::Interrupt>::udreInterrupt();
+}
+
+ISR(USART2_RX_vect)
+{
+    mm::UARTPort<2, mm::UARTMode::Interrupt>::rxInterrupt();
+}
+#endif
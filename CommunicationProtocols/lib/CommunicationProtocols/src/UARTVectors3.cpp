@@ -0,0 +1,17 @@
+#include "UARTPort.h"
+#include <avr/interrupt.h>
+
+#if defined(UDR3)
+// Referenced by UARTPort<3, UARTMode::Interrupt>::init(), which links this file
+const uint8_t mm::usart3_vectors = 0;
+
+ISR(USART3_UDRE_vect)
+{
+    mm::UARTPort<3, mm::UARTMode::Interrupt>::udreInterrupt();
+}
+
+ISR(USART3_RX_vect)
+{
+    mm::UARTPort<3, mm::UARTMode::Interrupt>::rxInterrupt();
+}
+#endif
@@ -1,9 +1,13 @@
-#ifndef COMMUNICATION_H
-#define COMMUNICATION_H
+#ifndef COMMUNICATION_LIBRARY_H
+#define COMMUNICATION_LIBRARY_H
 
 #include "CommunicationProtocol.h"
 #include "UART.h"
 #include "I2C.h"
+#include "I2CSlave.h"
 #include "SPI.h"
+#include "SPIBus.h"
+#include "SPISlave.h"
+#include "Telemetry.h"
 
-#endif // COMMUNICATION_H
\ No newline at end of file
+#endif // COMMUNICATION_LIBRARY_H
\ No newline at end of file
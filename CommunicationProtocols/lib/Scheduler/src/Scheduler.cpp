@@ -0,0 +1,154 @@
+#include "Scheduler.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+namespace
+{
+    /**
+     * @brief Checks whether tick `a` comes before tick `b`, across counter wrap-around.
+     */
+    bool before(uint32_t a, uint32_t b)
+    {
+        return (int32_t)(a - b) < 0;
+    }
+}
+
+uint8_t mm::Scheduler::nextReady(uint32_t now) const
+{
+    uint8_t next = invalid_task;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const Task &task = tasks[i];
+        if (!task.enabled || before(now, task.release))
+        {
+            continue;
+        }
+
+        if (next == invalid_task ||
+            before(task.release + task.deadline, tasks[next].release + tasks[next].deadline))
+        {
+            next = i;
+        }
+    }
+
+    return next;
+}
+
+uint8_t mm::Scheduler::addTask(TaskFunction function, uint16_t period, uint16_t deadline, uint16_t offset,
+                               void *context)
+{
+    if (count >= SCHEDULER_MAX_TASKS)
+    {
+        return invalid_task;
+    }
+
+    Task &task = tasks[count];
+    task.function = function;
+    task.context = context;
+    task.release = millis() + offset;
+    task.period = period;
+    task.deadline = deadline ? deadline : period ? period : UINT16_MAX;
+    task.enabled = period != 0;
+    task.statistics = TaskStatistics{};
+
+    return count++;
+}
+
+void mm::Scheduler::setPeriod(uint8_t task, uint16_t period)
+{
+    if (task < count)
+    {
+        tasks[task].period = period;
+    }
+}
+
+void mm::Scheduler::setEnabled(uint8_t task, bool enabled)
+{
+    if (task < count)
+    {
+        tasks[task].release = millis();
+        tasks[task].enabled = enabled;
+    }
+}
+
+void mm::Scheduler::trigger(uint8_t task, uint16_t delay)
+{
+    if (task < count)
+    {
+        tasks[task].release = millis() + delay;
+        tasks[task].enabled = true;
+    }
+}
+
+bool mm::Scheduler::runOnce()
+{
+    uint32_t now = millis();
+    uint8_t index = nextReady(now);
+    if (index == invalid_task)
+    {
+        return false;
+    }
+
+    Task &task = tasks[index];
+    uint32_t lateness = now - task.release;
+    if (lateness > task.statistics.max_lateness)
+    {
+        task.statistics.max_lateness = lateness > UINT16_MAX ? UINT16_MAX : lateness;
+    }
+
+    task.function(task.context);
+
+    now = millis();
+    task.statistics.runs++;
+    if (now - task.release > task.deadline)
+    {
+        task.statistics.deadline_misses++;
+    }
+
+    if (task.period == 0)
+    {
+        task.enabled = false;
+        return true;
+    }
+
+    // Stay on the release grid, but drop releases that are a whole period late
+    task.release += task.period;
+    while (now - task.release >= task.period && !before(now, task.release))
+    {
+        task.release += task.period;
+        task.statistics.skipped++;
+    }
+
+    return true;
+}
+
+void mm::Scheduler::run()
+{
+    for (;;)
+    {
+        if (runOnce())
+        {
+            continue;
+        }
+
+#if SCHEDULER_SLEEP
+        // Check again with interrupts off, so a tick cannot slip in before the sleep
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        cli();
+        if (nextReady(millis()) == invalid_task)
+        {
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+#endif
+    }
+}
+
+mm::TaskStatistics mm::Scheduler::statistics(uint8_t task) const
+{
+    return task < count ? tasks[task].statistics : TaskStatistics{};
+}
@@ -0,0 +1,171 @@
+/**
+ * @file Scheduler.h
+ * @brief Cooperative scheduler for periodic tasks with deadlines.
+ *
+ * This file defines the `Scheduler` class, which runs short task functions from the main
+ * loop at fixed periods measured by the millisecond tick, instead of blocking the CPU with
+ * busy-wait delays.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include "Tick.h"
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 8 ///< Number of tasks a scheduler can hold.
+#endif
+
+#ifndef SCHEDULER_SLEEP
+#define SCHEDULER_SLEEP 1 ///< Put the CPU in idle sleep while no task is ready.
+#endif
+
+namespace mm
+{
+    /**
+     * @brief Function run by a task.
+     *
+     * @param context The pointer given when the task was added.
+     */
+    typedef void (*TaskFunction)(void *context);
+
+    /**
+     * @brief Run-time statistics of a task.
+     */
+    struct TaskStatistics
+    {
+        uint16_t runs;            ///< Number of times the task ran.
+        uint16_t deadline_misses; ///< Runs that finished after the deadline.
+        uint16_t skipped;         ///< Releases dropped because the task was a whole period late.
+        uint16_t max_lateness;    ///< Longest time from release to start, in ticks.
+    };
+
+    /**
+     * @class Scheduler
+     * @brief Non-preemptive earliest-deadline-first scheduler driven by `millis()`.
+     *
+     * Each task is released every `period` ticks and should finish within `deadline`
+     * ticks of its release. Among the released tasks the one with the earliest absolute
+     * deadline runs next, ties go to the task added first. Tasks run to completion, so a
+     * task must not block for long; split long work into several runs instead.
+     *
+     * Releases follow a fixed grid, so a late run does not shift the following ones. A
+     * task that falls a whole period behind skips the missed releases instead of running
+     * back-to-back to catch up.
+     *
+     * @code
+     * mm::Scheduler scheduler;
+     * mm::initTick();
+     * sei();
+     * scheduler.addTask(readSensor, 1000, 20);
+     * scheduler.addTask(pollCommands, 10);
+     * scheduler.run();
+     * @endcode
+     */
+    class Scheduler
+    {
+    private:
+        /**
+         * @brief State of one task.
+         */
+        struct Task
+        {
+            TaskFunction function;     ///< Function to run.
+            void *context;             ///< Argument of the function.
+            uint32_t release;          ///< Tick of the next release.
+            uint16_t period;           ///< Ticks between releases, 0 for a task that only runs when triggered.
+            uint16_t deadline;         ///< Ticks from release to the latest allowed completion.
+            bool enabled;              ///< Whether the task is released at all.
+            TaskStatistics statistics; ///< Run-time statistics.
+        };
+
+        Task tasks[SCHEDULER_MAX_TASKS]; ///< Registered tasks, in priority order for ties.
+        uint8_t count;                   ///< Number of registered tasks.
+
+        /**
+         * @brief Finds the released task with the earliest deadline.
+         *
+         * @param now The current tick.
+         * @return The task index, or `invalid_task` if no task is released.
+         */
+        uint8_t nextReady(uint32_t now) const;
+
+    public:
+        static constexpr uint8_t invalid_task = 0xFF; ///< Returned when a task cannot be added.
+
+        /**
+         * @brief Constructs a scheduler without tasks.
+         */
+        Scheduler()
+            : count(0) {}
+
+        /**
+         * @brief Adds a task.
+         *
+         * @param function The function to run.
+         * @param period Ticks between releases, or 0 for a task that only runs after `trigger()`.
+         * @param deadline Ticks from release to the latest allowed completion, 0 for the period
+         *                 (no deadline for a task with period 0).
+         * @param offset Ticks from now to the first release, e.g. to order tasks of equal period.
+         * @param context Argument passed to the function.
+         * @return The task id, or `invalid_task` if all `SCHEDULER_MAX_TASKS` slots are used.
+         */
+        uint8_t addTask(TaskFunction function, uint16_t period, uint16_t deadline = 0, uint16_t offset = 0,
+                        void *context = nullptr);
+
+        /**
+         * @brief Changes the period of a task, starting from its next release.
+         *
+         * @param task The task id.
+         * @param period The new period in ticks.
+         */
+        void setPeriod(uint8_t task, uint16_t period);
+
+        /**
+         * @brief Enables or disables a task.
+         *
+         * Enabling a task releases it immediately.
+         *
+         * @param task The task id.
+         * @param enabled Whether the task should run.
+         */
+        void setEnabled(uint8_t task, bool enabled);
+
+        /**
+         * @brief Releases a task now or after a delay, independent of its period.
+         *
+         * Meant for tasks with period 0 that react to events, or that collect the result
+         * of something started earlier, e.g. a sensor conversion. Safe to call from tasks,
+         * not from interrupts.
+         *
+         * @param task The task id.
+         * @param delay Ticks from now to the release.
+         */
+        void trigger(uint8_t task, uint16_t delay = 0);
+
+        /**
+         * @brief Runs the next released task, if any.
+         *
+         * @return True if a task ran.
+         */
+        bool runOnce();
+
+        /**
+         * @brief Runs tasks forever.
+         *
+         * While no task is released the CPU sleeps in idle mode until the next interrupt
+         * (unless `SCHEDULER_SLEEP` is 0), which at the latest is the next tick.
+         */
+        void run();
+
+        /**
+         * @brief Returns the run-time statistics of a task.
+         *
+         * @param task The task id.
+         */
+        TaskStatistics statistics(uint8_t task) const;
+    };
+}
+
+#endif // SCHEDULER_H
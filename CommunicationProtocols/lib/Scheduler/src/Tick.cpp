@@ -0,0 +1,51 @@
+#include "Tick.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+namespace
+{
+    constexpr mm::TickTimer tick_timer = mm::tickTimer(F_CPU, TICK_TIMER);
+
+    volatile uint32_t tick_count; ///< Ticks since `initTick()`.
+}
+
+#if TICK_TIMER == 2
+ISR(TIMER2_COMPA_vect)
+#else
+ISR(TIMER0_COMPA_vect)
+#endif
+{
+    tick_count = tick_count + 1;
+}
+
+void mm::initTick()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        tick_count = 0;
+#if TICK_TIMER == 2
+        TCCR2A = (1 << WGM21);
+        TCCR2B = tick_timer.cs;
+        OCR2A = tick_timer.ocr;
+        TCNT2 = 0;
+        TIMSK2 |= (1 << OCIE2A);
+#else
+        TCCR0A = (1 << WGM01);
+        TCCR0B = tick_timer.cs;
+        OCR0A = tick_timer.ocr;
+        TCNT0 = 0;
+        TIMSK0 |= (1 << OCIE0A);
+#endif
+    }
+}
+
+uint32_t mm::millis()
+{
+    uint32_t ticks;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = tick_count;
+    }
+    return ticks;
+}
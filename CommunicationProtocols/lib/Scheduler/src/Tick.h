@@ -0,0 +1,135 @@
+/**
+ * @file Tick.h
+ * @brief Millisecond system tick from Timer0 or Timer2.
+ *
+ * This file declares `millis()` and the `constexpr` helpers that choose the clock select
+ * bits and compare value of an 8-bit timer in CTC mode, so the timer interrupts once per
+ * millisecond at any CPU clock.
+ */
+
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdint.h>
+
+#ifndef TICK_TIMER
+#define TICK_TIMER 0 ///< Timer generating the tick: 0 or 2.
+#endif
+
+#ifndef TICK_RATE
+#define TICK_RATE 1000UL ///< Tick interrupts per second.
+#endif
+
+namespace mm
+{
+    /**
+     * @struct TickTimer
+     * @brief Register values that make an 8-bit timer interrupt at the tick rate.
+     *
+     * rate = F_CPU / (prescaler * (OCR + 1))
+     */
+    struct TickTimer
+    {
+        uint8_t cs;  ///< Clock select bits for TCCRnB.
+        uint8_t ocr; ///< Value for the OCRnA compare register.
+    };
+
+    namespace tick
+    {
+        /**
+         * @brief Returns the prescaler factor selected by the clock select bits of a timer.
+         *
+         * Timer2 has the additional factors 32 and 128.
+         */
+        constexpr uint16_t prescaler(uint8_t timer, uint8_t cs)
+        {
+            return timer == 2
+                       ? (cs == 1 ? 1 : cs == 2 ? 8 : cs == 3 ? 32 : cs == 4 ? 64 : cs == 5 ? 128 : cs == 6 ? 256 : 1024)
+                       : (cs == 1 ? 1 : cs == 2 ? 8 : cs == 3 ? 64 : cs == 4 ? 256 : 1024);
+        }
+
+        /**
+         * @brief Returns the largest clock select value of a timer.
+         */
+        constexpr uint8_t maxClockSelect(uint8_t timer)
+        {
+            return timer == 2 ? 7 : 5;
+        }
+
+        /**
+         * @brief Returns the number of timer counts per tick, rounded to the nearest count.
+         */
+        constexpr uint32_t counts(uint32_t f_cpu, uint32_t rate, uint8_t timer, uint8_t cs)
+        {
+            return (f_cpu / prescaler(timer, cs) + rate / 2) / rate;
+        }
+
+        /**
+         * @brief Returns the smallest prescaler for which a tick fits in eight bits.
+         *
+         * The smallest prescaler gives the most accurate tick.
+         */
+        constexpr uint8_t selectClock(uint32_t f_cpu, uint32_t rate, uint8_t timer, uint8_t cs)
+        {
+            return cs >= maxClockSelect(timer) || counts(f_cpu, rate, timer, cs) <= 256
+                       ? cs
+                       : selectClock(f_cpu, rate, timer, cs + 1);
+        }
+
+        /**
+         * @brief Limits a count to the range of the compare register.
+         */
+        constexpr uint8_t compareValue(uint32_t counts)
+        {
+            return counts > 256 ? 255 : counts == 0 ? 0 : (uint8_t)(counts - 1);
+        }
+    }
+
+    /**
+     * @brief Chooses the register values for a timer interrupting at the given rate.
+     *
+     * @code
+     * constexpr mm::TickTimer t = mm::tickTimer(16000000UL, 0); // prescaler 64, OCR0A = 249
+     * @endcode
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param timer The timer, 0 or 2.
+     * @param rate The requested interrupt rate in Hz.
+     * @return The clock select bits and compare value to program.
+     */
+    constexpr TickTimer tickTimer(uint32_t f_cpu, uint8_t timer, uint32_t rate = TICK_RATE)
+    {
+        return TickTimer{tick::selectClock(f_cpu, rate, timer, 1),
+                         tick::compareValue(tick::counts(f_cpu, rate, timer, tick::selectClock(f_cpu, rate, timer, 1)))};
+    }
+
+    /**
+     * @brief Returns the interrupt rate produced by a register setting.
+     *
+     * @param f_cpu The CPU clock frequency in Hz.
+     * @param timer The timer, 0 or 2.
+     * @param setting The register setting.
+     * @return The rate in Hz, rounded down.
+     */
+    constexpr uint32_t tickFrequency(uint32_t f_cpu, uint8_t timer, TickTimer setting)
+    {
+        return f_cpu / tick::prescaler(timer, setting.cs) / (setting.ocr + 1UL);
+    }
+
+    /**
+     * @brief Starts the tick timer in CTC mode and enables its compare interrupt.
+     *
+     * The timer given by `TICK_TIMER` is reserved for the tick afterwards. Global
+     * interrupts must be enabled for the tick to advance.
+     */
+    void initTick();
+
+    /**
+     * @brief Returns the number of ticks since `initTick()`, i.e. milliseconds at the default rate.
+     *
+     * The counter wraps after about 49 days; compare times by subtraction.
+     */
+    uint32_t millis();
+}
+
+#endif // TICK_H
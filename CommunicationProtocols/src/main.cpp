@@ -1,54 +1,219 @@
 #include <avr/io.h>
-#include <util/delay.h>
-#include <stdio.h>
-#include <stdlib.h>
+#include <avr/interrupt.h>
 
-#include "sensor.h"
 #include "communication.h"
-//#include "sensorSPI.h"
+#include "BME280.h"
+#include "Scheduler.h"
 
-#define SCL_CLK 100000UL 
+#ifndef REPORT_BINARY
+#define REPORT_BINARY 1 ///< 1: COBS-framed binary telemetry, 0: human-readable text.
+#endif
 
-int main() {
-    double temperature;
-    double humidity;
-    double pressure;
+#ifndef SAMPLE_PERIOD_MS
+#define SAMPLE_PERIOD_MS 1000 ///< Period of the sensor read and the report.
+#endif
 
-    mm::UART uart;
-    uart.init();
+#ifndef SENSOR_SPI
+#define SENSOR_SPI 0 ///< 1: BME280 on SPI with chip select PB2, 0: on I2C at address 0x76.
+#endif
 
-    mm::I2C i2c;
-    i2c.init();
+#ifndef UART_BAUD
+#define UART_BAUD 57600UL ///< Speed of the report link; 115200 is 2.1 % off with a 16 MHz clock.
+#endif
 
-    // mm::SPI spi;
-    // spi.init();
+#define COMMAND_PERIOD_MS 10 ///< Polling period of the command input.
+#define COMMAND_LENGTH 8     ///< Longest command line.
 
-    uart.transmitString("Hello, UART!\n");
-    initBME280();
-    char buffer[20];
+#define BME280_ADDR 0x76                ///< I2C address of the BME280 (SDO low).
+#define BME280_I2C_FREQUENCY 400000UL   ///< The BME280 supports Fast Mode.
+#define BME280_SPI_FREQUENCY 10000000UL ///< The BME280 accepts SPI mode 0 or 3 up to 10 MHz.
+
+// With U2X the receiver tolerates about 1.5 % for 8N1 (ATmega328P datasheet, table 20-3)
+static_assert(mm::baudError(F_CPU, mm::baudSetting(F_CPU, UART_BAUD), UART_BAUD) < 150 &&
+                  mm::baudError(F_CPU, mm::baudSetting(F_CPU, UART_BAUD), UART_BAUD) > -150,
+              "UART_BAUD cannot be generated accurately enough from F_CPU");
+
+mm::StaticUART<0, mm::UARTMode::Interrupt> uart(UART_BAUD);
+
+#if SENSOR_SPI
+mm::SPIBus spi_bus;
+mm::SPIDevice bme280_device(spi_bus, DDRB, PORTB, PB2, mm::spiSettings(F_CPU, BME280_SPI_FREQUENCY, mm::SPIMode::Mode0));
+mm::BME280<mm::BME280SPI> bme280{mm::BME280SPI(bme280_device)};
+#else
+mm::I2C i2c(mm::Hz(BME280_I2C_FREQUENCY));
+mm::BME280<mm::BME280I2C> bme280{mm::BME280I2C(i2c, BME280_ADDR)};
+#endif
 
-    while(1){
-        readRawData(); 
+mm::Scheduler scheduler;
+uint8_t sensor_task;
+uint8_t read_task;
+uint8_t report_task;
 
-        temperature = getTemp();
-        humidity = getHum(); 
-        pressure = getPress();
+// Time of the last sensor read
+uint32_t sample_time;
 
-        dtostrf(temperature, 0, 2, buffer); // Convert temperature to string with 2 decimal places
-        uart.transmitString("Tempreture: ");
-        uart.transmitString(buffer);
-        uart.transmitString(" C\n");
+#if REPORT_BINARY
+// Sequence number of the next telemetry frame
+uint16_t telemetry_sequence;
+#endif
 
-        dtostrf(humidity, 0, 2, buffer); // Convert humidity to string with 2 decimal places
-        uart.transmitString("Humidity: ");
-        uart.transmitString(buffer);
-        uart.transmitString(" %\n");
+/**
+ * @brief Reports a sample that could not be taken.
+ *
+ * In binary mode the sequence number still advances, so the receiver counts the sample
+ * as lost instead of receiving stale values.
+ */
+void reportFailure()
+{
+#if REPORT_BINARY
+    telemetry_sequence++;
+#else
+    uart << MM_F("BME280 not responding\n");
+#endif
+}
 
-        dtostrf(pressure, 0, 2, buffer); // Convert pressure to string with 2 decimal places
-        uart.transmitString("Pressure: ");
-        uart.transmitString(buffer);
-        uart.transmitString(" hPa\n");
+/**
+ * @brief Starts a forced-mode measurement and schedules its read.
+ *
+ * If the sensor does not answer, no read is scheduled and the sample is reported as
+ * failed.
+ */
+void sensorTask(void *)
+{
+    if (!bme280.startMeasurement())
+    {
+        reportFailure();
+        return;
+    }
+
+    // Rounded up, plus one tick because the current tick may be almost over
+    scheduler.trigger(read_task, (uint16_t)((bme280.measurementTime() + 999) / 1000 + 1));
+}
+
+/**
+ * @brief Fetches the finished measurement from the BME280 and reports it.
+ *
+ * A failed read is not reported as a sample, since the stored readings are from the
+ * previous measurement.
+ */
+void readTask(void *)
+{
+    if (!bme280.readRawData())
+    {
+        reportFailure();
+        return;
+    }
+    sample_time = mm::millis();
+    scheduler.trigger(report_task);
+}
 
-        _delay_ms(1000);
+/**
+ * @brief Sends the latest measurement over UART.
+ */
+void reportTask(void *)
+{
+#if REPORT_BINARY
+    mm::TelemetrySample sample;
+    uint8_t frame[mm::telemetry::frame_size];
+
+    sample.sequence = telemetry_sequence++;
+    sample.timestamp = sample_time;
+    sample.temperature = (int16_t)bme280.getTemp();
+    sample.pressure = bme280.getPress();
+    sample.humidity = (uint16_t)humidityCentiPercent(bme280.getHum());
+    uart.write(frame, mm::encodeTelemetry(sample, frame));
+#else
+    // Fixed-point readings: 0.01 C, 0.01 %RH and 0.01 hPa
+    uart << MM_F("Tempreture: ") << mm::fixed(bme280.getTemp(), 2) << MM_F(" C\n");
+    uart << MM_F("Humidity: ") << mm::fixed(humidityCentiPercent(bme280.getHum()), 2) << MM_F(" %\n");
+    uart << MM_F("Pressure: ") << mm::fixed(pressureCentiHpa(bme280.getPress()), 2) << MM_F(" hPa\n");
+#endif
+}
+
+/**
+ * @brief Executes one command line.
+ *
+ * - `r`: read the sensor and report now
+ * - `p<ms>`: set the sample period, e.g. `p500`
+ */
+void executeCommand(const char *command)
+{
+    if (command[0] == 'r' && command[1] == '\0')
+    {
+        scheduler.trigger(sensor_task);
+    }
+    else if (command[0] == 'p')
+    {
+        uint32_t period = 0;
+        for (const char *c = command + 1; *c >= '0' && *c <= '9'; c++)
+        {
+            period = period * 10 + (*c - '0');
+        }
+        if (period >= 100 && period <= 60000)
+        {
+            scheduler.setPeriod(sensor_task, period);
+        }
     }
+}
+
+/**
+ * @brief Collects received bytes into command lines without waiting for input.
+ */
+void commandTask(void *)
+{
+    static char line[COMMAND_LENGTH + 1];
+    static uint8_t length;
+    uint8_t data;
+
+    while (uart.tryReceiveByte(data))
+    {
+        if (data == '\n' || data == '\r')
+        {
+            line[length] = '\0';
+            if (length)
+            {
+                executeCommand(line);
+            }
+            length = 0;
+        }
+        else if (length < COMMAND_LENGTH)
+        {
+            line[length++] = data;
+        }
+    }
+}
+
+int main() {
+    uart.init();
+    mm::initTick();
+    sei();
+
+#if SENSOR_SPI
+    spi_bus.init();
+#else
+    i2c.init();
+#endif
+
+#if REPORT_BINARY
+    // A zero byte first, so the receiver discards whatever it saw before
+    uart.transmitByte(0);
+#else
+    uart.transmitString("Hello, UART!\n");
+#endif
+    // The sensor sleeps between samples, one measurement takes at most 57.6 ms
+    if (bme280.init(mm::bme280Settings(mm::BME280Mode::Forced)))
+    {
+#if !REPORT_BINARY
+        uart.transmitString("BME280 detected!\n");
+#endif
+    }
+
+    // Each sample starts a measurement, the read follows when it is done and the report
+    // right after the read
+    sensor_task = scheduler.addTask(sensorTask, SAMPLE_PERIOD_MS, 10);
+    read_task = scheduler.addTask(readTask, 0, 10);
+    report_task = scheduler.addTask(reportTask, 0, 50);
+    scheduler.addTask(commandTask, COMMAND_PERIOD_MS);
+
+    scheduler.run();
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "TelemetryDecoder.h"
+
+mm::TelemetryDecoder::TelemetryDecoder()
+    : length(0), synced(false), overflow(false), has_sequence(false), last_sequence(0), last_timestamp(0),
+      stats{0, 0, 0, 0}
+{
+}
+
+bool mm::TelemetryDecoder::feed(uint8_t byte, TelemetrySample &sample)
+{
+    if (!synced)
+    {
+        // The bytes before the first delimiter are the tail of a frame we did not see
+        synced = byte == 0;
+        return false;
+    }
+
+    if (byte != 0)
+    {
+        if (length < sizeof(buffer))
+        {
+            buffer[length++] = byte;
+        }
+        else
+        {
+            overflow = true;
+        }
+        return false;
+    }
+
+    // A delimiter ends the frame; empty frames are just padding
+    bool empty = length == 0 && !overflow;
+    bool good = !empty && !overflow && decodeTelemetry(buffer, length, sample);
+    length = 0;
+    overflow = false;
+
+    if (empty)
+    {
+        return false;
+    }
+    if (!good)
+    {
+        stats.bad_frames++;
+        return false;
+    }
+
+    if (has_sequence)
+    {
+        // Signed differences keep the wrap-around of both counters working
+        int16_t step = (int16_t)(uint16_t)(sample.sequence - last_sequence);
+        int32_t elapsed = (int32_t)(sample.timestamp - last_timestamp);
+        if (step <= 0 || elapsed < 0)
+        {
+            stats.restarts++;
+        }
+        else
+        {
+            stats.lost_frames += step - 1;
+        }
+    }
+    has_sequence = true;
+    last_sequence = sample.sequence;
+    last_timestamp = sample.timestamp;
+    stats.frames++;
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file TelemetryDecoder.h
+ * @brief Host-side reassembly of telemetry frames from a byte stream.
+ *
+ * This file defines the `TelemetryDecoder` class, which splits a serial byte stream at
+ * the zero delimiters, decodes each frame with `decodeTelemetry()` and keeps statistics
+ * about damaged and lost frames.
+ */
+
+#ifndef TELEMETRY_DECODER_H
+#define TELEMETRY_DECODER_H
+
+#include <stdint.h>
+#include "Telemetry.h"
+
+namespace mm
+{
+    /**
+     * @brief Counters of a `TelemetryDecoder`.
+     */
+    struct TelemetryStatistics
+    {
+        uint32_t frames;      ///< Frames decoded successfully.
+        uint32_t bad_frames;  ///< Frames with a COBS, length, type or CRC error.
+        uint32_t lost_frames; ///< Frames missing according to the sequence numbers.
+        uint32_t restarts;    ///< Sequence or time went backwards, e.g. the node rebooted.
+    };
+
+    /**
+     * @class TelemetryDecoder
+     * @brief Turns a byte stream into telemetry samples.
+     *
+     * Bytes are collected until a zero arrives. Everything before the first zero is
+     * discarded, since the stream may have been opened in the middle of a frame. A
+     * damaged frame is counted and dropped; the decoder is in sync again at the next
+     * zero, so line noise costs at most the frames it touches.
+     *
+     * Gaps in the sequence numbers are counted as lost frames. A sequence number or
+     * timestamp that goes backwards means the node restarted; the counting starts over
+     * from that frame instead of adding a wrapped-around gap.
+     */
+    class TelemetryDecoder
+    {
+    private:
+        uint8_t buffer[telemetry::frame_size]; ///< Encoded bytes of the current frame.
+        uint8_t length;                        ///< Bytes in `buffer`.
+        bool synced;                           ///< The first delimiter has been seen.
+        bool overflow;                         ///< The current frame is longer than any valid one.
+        bool has_sequence;                     ///< `last_sequence` holds a received value.
+        uint16_t last_sequence;                ///< Sequence number of the last good frame.
+        uint32_t last_timestamp;               ///< Timestamp of the last good frame.
+        TelemetryStatistics stats;             ///< Frame counters.
+
+    public:
+        /**
+         * @brief Constructs a decoder waiting for the first delimiter.
+         */
+        TelemetryDecoder();
+
+        /**
+         * @brief Processes one received byte.
+         *
+         * @param byte The received byte.
+         * @param sample Receives the sample when a frame is complete.
+         * @return True if `sample` holds a newly decoded sample.
+         */
+        bool feed(uint8_t byte, TelemetrySample &sample);
+
+        /**
+         * @brief Returns the frame counters.
+         */
+        const TelemetryStatistics &statistics() const
+        {
+            return stats;
+        }
+    };
+}
+
+#endif // TELEMETRY_DECODER_H
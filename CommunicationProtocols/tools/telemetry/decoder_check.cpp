@@ -0,0 +1,202 @@
+/**
+ * @file decoder_check.cpp
+ * @brief Pass/fail tests of `TelemetryDecoder` on constructed byte streams.
+ *
+ * Each test builds the bytes a receiver would see on the serial line: frames from
+ * `encodeTelemetry()`, a stream opened in the middle of a frame, damaged and overlong
+ * frames, missing sequence numbers and a node that reboots. Each check prints one line,
+ * and the program exits with a non-zero status if any of them fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "TelemetryDecoder.h"
+
+namespace
+{
+    int failures = 0;
+
+    /**
+     * @brief Prints the result of one check and records a failure.
+     */
+    void check(bool condition, const char *what)
+    {
+        printf("%-4s %s\n", condition ? "ok" : "FAIL", what);
+        if (!condition)
+        {
+            failures++;
+        }
+    }
+
+    /**
+     * @brief A byte stream as seen by the receiver.
+     */
+    class Stream
+    {
+    private:
+        std::vector<uint8_t> bytes;
+
+    public:
+        /**
+         * @brief Appends the frame of a sample and returns the offset of its first byte.
+         */
+        size_t frame(uint16_t sequence, uint32_t timestamp)
+        {
+            uint8_t encoded[mm::telemetry::frame_size];
+            mm::TelemetrySample sample = {sequence, timestamp, 2315, 25767168, 4550};
+            uint8_t len = mm::encodeTelemetry(sample, encoded);
+            size_t offset = bytes.size();
+            bytes.insert(bytes.end(), encoded, encoded + len);
+            return offset;
+        }
+
+        /**
+         * @brief Appends raw bytes.
+         */
+        void raw(uint8_t byte, size_t count)
+        {
+            bytes.insert(bytes.end(), count, byte);
+        }
+
+        /**
+         * @brief Flips bits of a byte without turning it into a delimiter.
+         */
+        void corrupt(size_t offset)
+        {
+            bytes[offset] ^= bytes[offset] == 0x55 ? 0xAA : 0x55;
+        }
+
+        /**
+         * @brief Drops the first `count` bytes, as if the stream was opened late.
+         */
+        void skip(size_t count)
+        {
+            bytes.erase(bytes.begin(), bytes.begin() + count);
+        }
+
+        /**
+         * @brief Feeds the stream to a decoder and collects the sequence numbers of the samples.
+         */
+        std::vector<uint16_t> decode(mm::TelemetryDecoder &decoder) const
+        {
+            std::vector<uint16_t> sequences;
+            mm::TelemetrySample sample;
+            for (uint8_t byte : bytes)
+            {
+                if (decoder.feed(byte, sample))
+                {
+                    sequences.push_back(sample.sequence);
+                }
+            }
+            return sequences;
+        }
+    };
+
+    /**
+     * @brief Compares the decoder statistics with the expected counters.
+     */
+    bool counted(const mm::TelemetryDecoder &decoder, uint32_t frames, uint32_t bad_frames, uint32_t lost_frames,
+                 uint32_t restarts)
+    {
+        const mm::TelemetryStatistics &stats = decoder.statistics();
+        return stats.frames == frames && stats.bad_frames == bad_frames && stats.lost_frames == lost_frames &&
+               stats.restarts == restarts;
+    }
+
+    void checkSync()
+    {
+        Stream stream;
+        mm::TelemetryDecoder decoder;
+
+        // Opened in the middle of frame 1: its tail is discarded up to the delimiter
+        stream.frame(1, 1000);
+        stream.skip(5);
+        stream.frame(2, 2000);
+        stream.raw(0, 3);
+        stream.frame(3, 3000);
+        std::vector<uint16_t> sequences = stream.decode(decoder);
+        check(sequences == std::vector<uint16_t>({2, 3}) && counted(decoder, 2, 0, 0, 0),
+              "Decoder skips a partial frame before the first delimiter");
+
+        Stream noise;
+        mm::TelemetryDecoder idle;
+        noise.raw(0x7E, 100);
+        check(noise.decode(idle).empty() && counted(idle, 0, 0, 0, 0), "Decoder waits for the first delimiter");
+    }
+
+    void checkDamage()
+    {
+        Stream stream;
+        mm::TelemetryDecoder decoder;
+
+        stream.raw(0, 1);
+        stream.frame(1, 1000);
+        stream.corrupt(stream.frame(2, 2000) + 4);
+        stream.frame(3, 3000);
+        std::vector<uint16_t> sequences = stream.decode(decoder);
+        check(sequences == std::vector<uint16_t>({1, 3}) && counted(decoder, 2, 1, 1, 0),
+              "Decoder drops a corrupted frame and counts it lost");
+
+        // A run of noise longer than any frame is one bad frame, then the decoder is in sync
+        Stream overlong;
+        mm::TelemetryDecoder resync;
+        overlong.raw(0, 1);
+        overlong.raw(0x33, 3 * mm::telemetry::frame_size);
+        overlong.raw(0, 1);
+        overlong.frame(1, 1000);
+        check(overlong.decode(resync) == std::vector<uint16_t>({1}) && counted(resync, 1, 1, 0, 0),
+              "Decoder resynchronizes after an overlong frame");
+    }
+
+    void checkSequence()
+    {
+        Stream stream;
+        mm::TelemetryDecoder decoder;
+
+        stream.raw(0, 1);
+        stream.frame(10, 1000);
+        stream.frame(11, 2000);
+        stream.frame(14, 5000);
+        std::vector<uint16_t> sequences = stream.decode(decoder);
+        check(sequences.size() == 3 && counted(decoder, 3, 0, 2, 0), "Decoder counts a gap in the sequence numbers");
+
+        // The node reboots: sequence and time start over without a wrapped-around gap
+        Stream reboot;
+        reboot.frame(0, 20);
+        reboot.frame(1, 1020);
+        reboot.decode(decoder);
+        check(counted(decoder, 5, 0, 2, 1), "Decoder detects a reboot from the sequence number");
+
+        // The sequence number goes on but time jumps back
+        Stream clock;
+        clock.frame(2, 10);
+        clock.decode(decoder);
+        check(counted(decoder, 6, 0, 2, 2), "Decoder detects a restart from the timestamp");
+
+        // Both counters wrap around without a loss or a restart
+        Stream wrap;
+        mm::TelemetryDecoder wrapping;
+        wrap.raw(0, 1);
+        wrap.frame(0xFFFE, 0xFFFFF000UL);
+        wrap.frame(0xFFFF, 0xFFFFFC00UL);
+        wrap.frame(0, 0x00000200UL);
+        check(wrap.decode(wrapping).size() == 3 && counted(wrapping, 3, 0, 0, 0),
+              "Decoder handles wrap-around of sequence and timestamp");
+    }
+}
+
+int main()
+{
+    checkSync();
+    checkDamage();
+    checkSequence();
+
+    if (failures)
+    {
+        printf("\n%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("\nall checks passed\n");
+    return EXIT_SUCCESS;
+}
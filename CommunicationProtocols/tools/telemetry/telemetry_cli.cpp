@@ -0,0 +1,117 @@
+/**
+ * @file telemetry_cli.cpp
+ * @brief Command line decoder for the binary telemetry stream.
+ *
+ * Reads frames from a serial port or standard input and prints one CSV line per sample:
+ *
+ *     telemetry /dev/ttyACM0 57600
+ *     telemetry < capture.bin
+ *
+ * Frame statistics are written to standard error at the end of the input.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "TelemetryDecoder.h"
+
+namespace
+{
+    /**
+     * @brief Maps a numeric baud rate to its termios constant.
+     */
+    speed_t baudConstant(long baud)
+    {
+        switch (baud)
+        {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 115200:
+            return B115200;
+        default:
+            return B0;
+        }
+    }
+
+    /**
+     * @brief Opens a serial port in raw mode.
+     *
+     * @return The file descriptor, or -1 after printing an error.
+     */
+    int openSerial(const char *path, long baud)
+    {
+        speed_t speed = baudConstant(baud);
+        if (speed == B0)
+        {
+            fprintf(stderr, "unsupported baud rate %ld\n", baud);
+            return -1;
+        }
+
+        int fd = open(path, O_RDONLY | O_NOCTTY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return -1;
+        }
+
+        struct termios tty;
+        if (tcgetattr(fd, &tty) == 0)
+        {
+            cfmakeraw(&tty);
+            cfsetispeed(&tty, speed);
+            cfsetospeed(&tty, speed);
+            tty.c_cflag |= CLOCAL | CREAD;
+            tty.c_cc[VMIN] = 1;
+            tty.c_cc[VTIME] = 0;
+            tcsetattr(fd, TCSANOW, &tty);
+        }
+        return fd;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int fd = STDIN_FILENO;
+    if (argc > 1)
+    {
+        fd = openSerial(argv[1], argc > 2 ? strtol(argv[2], nullptr, 10) : 57600);
+        if (fd < 0)
+        {
+            return 1;
+        }
+    }
+
+    mm::TelemetryDecoder decoder;
+    mm::TelemetrySample sample;
+    uint8_t chunk[256];
+    ssize_t count;
+
+    printf("sequence,timestamp_ms,temperature_c,pressure_hpa,humidity_pct\n");
+    while ((count = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        for (ssize_t i = 0; i < count; i++)
+        {
+            if (decoder.feed(chunk[i], sample))
+            {
+                printf("%u,%lu,%.2f,%.2f,%.2f\n", sample.sequence, (unsigned long)sample.timestamp,
+                       sample.temperature / 100.0, sample.pressure / 25600.0, sample.humidity / 100.0);
+                fflush(stdout);
+            }
+        }
+    }
+
+    const mm::TelemetryStatistics &stats = decoder.statistics();
+    fprintf(stderr, "frames: %lu, bad: %lu, lost: %lu, restarts: %lu\n", (unsigned long)stats.frames,
+            (unsigned long)stats.bad_frames, (unsigned long)stats.lost_frames, (unsigned long)stats.restarts);
+    return 0;
+}